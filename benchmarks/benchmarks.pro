@@ -0,0 +1,36 @@
+TARGET = nymea-networkmanager-benchmark
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+QT += dbus network
+QT -= gui
+
+greaterThan(QT_MAJOR_VERSION, 5) {
+    CONFIG *= c++17
+    QMAKE_LFLAGS *= -std=c++17
+    QMAKE_CXXFLAGS *= -std=c++17
+} else {
+    CONFIG *= c++11
+    QMAKE_LFLAGS *= -std=c++11
+    QMAKE_CXXFLAGS *= -std=c++11
+    DEFINES += QT_DISABLE_DEPRECATED_UP_TO=0x050F00
+}
+
+QMAKE_CXXFLAGS *= -Werror -g
+
+INCLUDEPATH += $$PWD/../libnymea-networkmanager
+LIBS += -L$$OUT_PWD/../libnymea-networkmanager -lnymea-networkmanager
+QMAKE_RPATHDIR += $$OUT_PWD/../libnymea-networkmanager
+
+HEADERS += \
+    mocknetworkmanager.h \
+    networkmanagerbenchmark.h
+
+SOURCES += \
+    main.cpp \
+    mocknetworkmanager.cpp \
+    networkmanagerbenchmark.cpp
+
+# Note: the benchmark is not installed, run it from the build directory
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <QTimer>
+#include <QLoggingCategory>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include "mocknetworkmanager.h"
+#include "networkmanagerbenchmark.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    application.setApplicationName("nymea-networkmanager-benchmark");
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.setApplicationDescription("Measures libnymea-networkmanager against a mock NetworkManager running on a private DBus.");
+
+    QCommandLineOption wirelessDevicesOption("wireless-devices", "The number of mock wireless devices.", "count", "1");
+    QCommandLineOption wiredDevicesOption("wired-devices", "The number of mock wired devices.", "count", "1");
+    QCommandLineOption accessPointsOption("access-points", "The number of mock access points per wireless device.", "count", "100");
+    QCommandLineOption connectionsOption("connections", "The number of mock connection settings.", "count", "20");
+    QCommandLineOption iterationsOption("iterations", "The number of iterations per benchmark.", "count", "10");
+    QCommandLineOption churnOption("churn", "The number of access points replaced per wireless device and churn iteration.", "count", "50");
+    QCommandLineOption verboseOption("verbose", "Print the debug output of the library.");
+    QCommandLineOption mockOption("mock", "Run only the mock NetworkManager on the bus given by DBUS_SYSTEM_BUS_ADDRESS.");
+    parser.addOptions({wirelessDevicesOption, wiredDevicesOption, accessPointsOption, connectionsOption, iterationsOption, churnOption, verboseOption, mockOption});
+    parser.process(application);
+
+    if (!parser.isSet(verboseOption))
+        QLoggingCategory::setFilterRules("NetworkManager.debug=false");
+
+    MockNetworkManager::Configuration configuration;
+    configuration.wirelessDevices = parser.value(wirelessDevicesOption).toInt();
+    configuration.wiredDevices = parser.value(wiredDevicesOption).toInt();
+    configuration.accessPoints = parser.value(accessPointsOption).toInt();
+    configuration.connections = parser.value(connectionsOption).toInt();
+
+    if (parser.isSet(mockOption)) {
+        // Never claim the NetworkManager name on the real system bus
+        if (qgetenv("DBUS_SYSTEM_BUS_ADDRESS").isEmpty()) {
+            qWarning() << "Refusing to run the mock without DBUS_SYSTEM_BUS_ADDRESS pointing to a private bus.";
+            return 1;
+        }
+
+        MockNetworkManager mock(configuration);
+        if (!mock.registerService(QDBusConnection::systemBus()))
+            return 1;
+
+        return application.exec();
+    }
+
+    NetworkManagerBenchmark benchmark(configuration, parser.value(iterationsOption).toInt(), parser.value(churnOption).toInt());
+    QTimer::singleShot(0, &benchmark, [&application, &benchmark](){
+        application.exit(benchmark.run());
+    });
+
+    return application.exec();
+}
@@ -0,0 +1,705 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "mocknetworkmanager.h"
+
+#include <time.h>
+
+#include <QUuid>
+#include <QTimer>
+#include <QDBusMetaType>
+#include <QDBusArgument>
+#include <QDBusVariant>
+
+static const QString propertiesInterface = QStringLiteral("org.freedesktop.DBus.Properties");
+static const QString activeConnectionInterface = QStringLiteral("org.freedesktop.NetworkManager.Connection.Active");
+
+MockNetworkManager::MockNetworkManager(const Configuration &configuration, QObject *parent) :
+    QDBusVirtualObject(parent),
+    m_connection(QString()),
+    m_configuration(configuration)
+{
+    NetworkConnection::registerTypes();
+    qDBusRegisterMetaType<NMManagedObjects>();
+
+    NMInterfacesMap networkManager;
+    networkManager.insert(NetworkManagerUtils::networkManagerServiceString(), {
+                              {"Version", "1.46.0"},
+                              {"State", 70u},
+                              {"Connectivity", 4u},
+                              {"NetworkingEnabled", true},
+                              {"WirelessEnabled", true},
+                              {"WirelessHardwareEnabled", true},
+                              {"Devices", QVariant::fromValue(QList<QDBusObjectPath>())},
+                              {"AllDevices", QVariant::fromValue(QList<QDBusObjectPath>())},
+                              {"ActiveConnections", QVariant::fromValue(QList<QDBusObjectPath>())},
+                              {"PrimaryConnection", QVariant::fromValue(QDBusObjectPath("/"))}
+                          });
+    m_objects.insert(NetworkManagerUtils::networkManagerPathString(), networkManager);
+
+    NMInterfacesMap settings;
+    settings.insert(NetworkManagerUtils::settingsInterfaceString(), {
+                        {"Connections", QVariant::fromValue(QList<QDBusObjectPath>())},
+                        {"Hostname", "nymea-benchmark"},
+                        {"CanModify", true}
+                    });
+    m_objects.insert(NetworkManagerUtils::settingsPathString(), settings);
+
+    for (int i = 0; i < m_configuration.wiredDevices; i++)
+        addDevice(1, QString("eth%1").arg(i));
+
+    for (int i = 0; i < m_configuration.wirelessDevices; i++) {
+        QString devicePath = addDevice(2, QString("wlan%1").arg(i));
+        for (int j = 0; j < m_configuration.accessPoints; j++) {
+            addAccessPoint(devicePath);
+        }
+    }
+
+    for (int i = 0; i < m_configuration.connections; i++) {
+        QVariantMap connectionSettings {
+            {"id", QString("Connection %1").arg(i)},
+            {"uuid", QUuid::createUuid().toString().remove("{").remove("}")},
+            {"type", "802-11-wireless"},
+            {"autoconnect", true}
+        };
+
+        ConnectionSettings settings;
+        settings.insert("connection", connectionSettings);
+        settings.insert("802-11-wireless", {{"ssid", QString("Network %1").arg(i).toUtf8()}, {"mode", "infrastructure"}});
+        addConnection(settings);
+    }
+}
+
+bool MockNetworkManager::registerService(const QDBusConnection &connection)
+{
+    m_connection = connection;
+    if (!m_connection.isConnected()) {
+        qWarning() << "Mock: DBus not connected";
+        return false;
+    }
+
+    if (!m_connection.registerVirtualObject(NetworkManagerUtils::objectManagerPathString(), this, QDBusConnection::SubPath)) {
+        qWarning() << "Mock: Could not register objects" << m_connection.lastError().message();
+        return false;
+    }
+
+    if (!m_connection.registerService(NetworkManagerUtils::networkManagerServiceString())) {
+        qWarning() << "Mock: Could not register service" << m_connection.lastError().message();
+        return false;
+    }
+
+    return true;
+}
+
+QString MockNetworkManager::introspect(const QString &path) const
+{
+    Q_UNUSED(path)
+    // Note: the library does not introspect
+    return QString();
+}
+
+bool MockNetworkManager::handleMessage(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    Q_UNUSED(connection)
+
+    if (message.type() != QDBusMessage::MethodCallMessage)
+        return false;
+
+    bool handled = false;
+    if (message.interface() == propertiesInterface) {
+        handled = handlePropertiesCall(message);
+    } else if (message.interface() == NetworkManagerUtils::objectManagerInterfaceString()) {
+        handled = handleObjectManagerCall(message);
+    } else if (message.interface() == NetworkManagerUtils::networkManagerServiceString()) {
+        handled = handleNetworkManagerCall(message);
+    } else if (message.interface() == NetworkManagerUtils::settingsInterfaceString()) {
+        handled = handleSettingsCall(message);
+    } else if (message.interface() == NetworkManagerUtils::connectionsInterfaceString()) {
+        handled = handleConnectionCall(message);
+    } else if (message.interface() == NetworkManagerUtils::deviceInterfaceString()) {
+        handled = handleDeviceCall(message);
+    } else if (message.interface() == NetworkManagerUtils::wirelessInterfaceString()) {
+        handled = handleWirelessCall(message);
+    } else if (message.interface() == benchmarkInterfaceString()) {
+        handled = handleBenchmarkCall(message);
+    }
+
+    if (!handled)
+        sendError(message, "org.freedesktop.DBus.Error.UnknownMethod", QString("Unknown method %1.%2 on %3").arg(message.interface(), message.member(), message.path()));
+
+    return true;
+}
+
+QString MockNetworkManager::benchmarkPathString()
+{
+    return "/org/freedesktop/NetworkManager/Benchmark";
+}
+
+QString MockNetworkManager::benchmarkInterfaceString()
+{
+    return "io.nymea.networkmanager.Benchmark";
+}
+
+QString MockNetworkManager::addDevice(uint deviceType, const QString &interface)
+{
+    QString path = QString("/org/freedesktop/NetworkManager/Devices/%1").arg(++m_deviceCounter);
+    QString hardwareAddress = QString("02:00:00:00:%1:%2").arg(m_deviceCounter / 256, 2, 16, QChar('0')).arg(m_deviceCounter % 256, 2, 16, QChar('0')).toUpper();
+
+    NMInterfacesMap device;
+    device.insert(NetworkManagerUtils::deviceInterfaceString(), {
+                      {"Udi", QString("/sys/devices/virtual/net/%1").arg(interface)},
+                      {"Interface", interface},
+                      {"IpInterface", interface},
+                      {"Driver", "mock"},
+                      {"DriverVersion", "1.0"},
+                      {"FirmwareVersion", "N/A"},
+                      {"PhysicalPortId", ""},
+                      {"Mtu", 1500u},
+                      {"Metered", 0u},
+                      {"Autoconnect", true},
+                      {"State", deviceType == 2 ? 30u : 100u},
+                      {"DeviceType", deviceType},
+                      {"ActiveConnection", QVariant::fromValue(QDBusObjectPath("/"))},
+                      {"Ip4Config", QVariant::fromValue(QDBusObjectPath("/"))},
+                      {"Ip6Config", QVariant::fromValue(QDBusObjectPath("/"))},
+                      {"AvailableConnections", QVariant::fromValue(QList<QDBusObjectPath>())}
+                  });
+
+    if (deviceType == 2) {
+        device.insert(NetworkManagerUtils::wirelessInterfaceString(), {
+                          {"HwAddress", hardwareAddress},
+                          {"PermHwAddress", hardwareAddress},
+                          {"Mode", 2u},
+                          {"Bitrate", 0u},
+                          {"AccessPoints", QVariant::fromValue(QList<QDBusObjectPath>())},
+                          {"ActiveAccessPoint", QVariant::fromValue(QDBusObjectPath("/"))},
+                          {"WirelessCapabilities", 0x07ffu},
+                          {"LastScan", bootTime()}
+                      });
+    } else {
+        device.insert(NetworkManagerUtils::wiredInterfaceString(), {
+                          {"HwAddress", hardwareAddress},
+                          {"PermHwAddress", hardwareAddress},
+                          {"Speed", 1000u},
+                          {"Bitrate", 1000u},
+                          {"Carrier", true}
+                      });
+    }
+
+    m_objects.insert(path, device);
+    appendObjectPath(NetworkManagerUtils::networkManagerPathString(), NetworkManagerUtils::networkManagerServiceString(), "Devices", path);
+    appendObjectPath(NetworkManagerUtils::networkManagerPathString(), NetworkManagerUtils::networkManagerServiceString(), "AllDevices", path);
+    emitSignal(NetworkManagerUtils::networkManagerPathString(), NetworkManagerUtils::networkManagerServiceString(), "DeviceAdded", {QVariant::fromValue(QDBusObjectPath(path))});
+    return path;
+}
+
+QString MockNetworkManager::addAccessPoint(const QString &devicePath)
+{
+    int index = ++m_accessPointCounter;
+    QString path = QString("/org/freedesktop/NetworkManager/AccessPoint/%1").arg(index);
+
+    // Every fourth access point shares the SSID of its predecessor, like a network with multiple BSSIDs
+    int ssidIndex = index % 4 == 0 ? index - 1 : index;
+
+    NMInterfacesMap accessPoint;
+    accessPoint.insert(NetworkManagerUtils::accessPointInterfaceString(), {
+                           {"Flags", 1u},
+                           {"WpaFlags", 0u},
+                           {"RsnFlags", 0x188u},
+                           {"Ssid", QString("Network %1").arg(ssidIndex).toUtf8()},
+                           {"Frequency", index % 2 ? 2412u : 5180u},
+                           {"HwAddress", QString("02:00:%1:%2:%3:%4").arg((index >> 24) & 0xff, 2, 16, QChar('0')).arg((index >> 16) & 0xff, 2, 16, QChar('0')).arg((index >> 8) & 0xff, 2, 16, QChar('0')).arg(index & 0xff, 2, 16, QChar('0')).toUpper()},
+                           {"Mode", 2u},
+                           {"MaxBitrate", 270000u},
+                           {"Strength", QVariant::fromValue(static_cast<uchar>(20 + (index * 37) % 80))},
+                           {"LastSeen", static_cast<int>(bootTime() / 1000)}
+                       });
+
+    m_objects.insert(path, accessPoint);
+    m_accessPointDevices.insert(path, devicePath);
+    appendObjectPath(devicePath, NetworkManagerUtils::wirelessInterfaceString(), "AccessPoints", path);
+    emitSignal(devicePath, NetworkManagerUtils::wirelessInterfaceString(), "AccessPointAdded", {QVariant::fromValue(QDBusObjectPath(path))});
+    return path;
+}
+
+bool MockNetworkManager::removeAccessPoint(const QString &accessPointPath)
+{
+    if (!m_accessPointDevices.contains(accessPointPath))
+        return false;
+
+    QString devicePath = m_accessPointDevices.take(accessPointPath);
+    m_objects.remove(accessPointPath);
+    removeObjectPath(devicePath, NetworkManagerUtils::wirelessInterfaceString(), "AccessPoints", accessPointPath);
+    emitSignal(devicePath, NetworkManagerUtils::wirelessInterfaceString(), "AccessPointRemoved", {QVariant::fromValue(QDBusObjectPath(accessPointPath))});
+    return true;
+}
+
+QString MockNetworkManager::addConnection(const ConnectionSettings &settings, bool unsaved)
+{
+    QString path = QString("%1/%2").arg(NetworkManagerUtils::settingsPathString()).arg(++m_connectionCounter);
+
+    NMInterfacesMap connection;
+    connection.insert(NetworkManagerUtils::connectionsInterfaceString(), {
+                          {"Unsaved", unsaved},
+                          {"Flags", unsaved ? 1u : 0u},
+                          {"Filename", unsaved ? QString() : QString("/etc/NetworkManager/system-connections/%1.nmconnection").arg(m_connectionCounter)}
+                      });
+
+    m_objects.insert(path, connection);
+    m_connectionSettings.insert(path, settings);
+    appendObjectPath(NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), "Connections", path);
+    emitSignal(NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), "NewConnection", {QVariant::fromValue(QDBusObjectPath(path))});
+    return path;
+}
+
+bool MockNetworkManager::removeConnection(const QString &connectionPath)
+{
+    if (!m_connectionSettings.contains(connectionPath))
+        return false;
+
+    m_connectionSettings.remove(connectionPath);
+    m_objects.remove(connectionPath);
+    emitSignal(connectionPath, NetworkManagerUtils::connectionsInterfaceString(), "Removed", QVariantList());
+    removeObjectPath(NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), "Connections", connectionPath);
+    emitSignal(NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), "ConnectionRemoved", {QVariant::fromValue(QDBusObjectPath(connectionPath))});
+    return true;
+}
+
+QString MockNetworkManager::activateConnection(const QString &connectionPath, const QString &devicePath)
+{
+    const QString deviceInterface = NetworkManagerUtils::deviceInterfaceString();
+    const ConnectionSettings settings = m_connectionSettings.value(connectionPath);
+
+    // Replace the current activation of this device
+    QString previousPath = qvariant_cast<QDBusObjectPath>(property(devicePath, deviceInterface, "ActiveConnection")).path();
+    if (m_objects.contains(previousPath)) {
+        m_objects.remove(previousPath);
+        removeObjectPath(NetworkManagerUtils::networkManagerPathString(), NetworkManagerUtils::networkManagerServiceString(), "ActiveConnections", previousPath);
+    }
+
+    QString path = QString("/org/freedesktop/NetworkManager/ActiveConnection/%1").arg(++m_activeConnectionCounter);
+    NMInterfacesMap activeConnection;
+    activeConnection.insert(activeConnectionInterface, {
+                                {"Connection", QVariant::fromValue(QDBusObjectPath(connectionPath))},
+                                {"Devices", QVariant::fromValue(QList<QDBusObjectPath>() << QDBusObjectPath(devicePath))},
+                                {"Id", settings.value("connection").value("id")},
+                                {"Uuid", settings.value("connection").value("uuid")},
+                                {"Type", settings.value("connection").value("type")},
+                                {"State", 2u}
+                            });
+    m_objects.insert(path, activeConnection);
+    appendObjectPath(NetworkManagerUtils::networkManagerPathString(), NetworkManagerUtils::networkManagerServiceString(), "ActiveConnections", path);
+
+    setProperty(devicePath, deviceInterface, "ActiveConnection", QVariant::fromValue(QDBusObjectPath(path)));
+
+    // Associate the access point with the SSID of the connection
+    if (m_objects.value(devicePath).contains(NetworkManagerUtils::wirelessInterfaceString())) {
+        QByteArray ssid = settings.value("802-11-wireless").value("ssid").toByteArray();
+        foreach (const QDBusObjectPath &accessPointPath, objectPaths(devicePath, NetworkManagerUtils::wirelessInterfaceString(), "AccessPoints")) {
+            if (property(accessPointPath.path(), NetworkManagerUtils::accessPointInterfaceString(), "Ssid").toByteArray() == ssid) {
+                setProperty(devicePath, NetworkManagerUtils::wirelessInterfaceString(), "ActiveAccessPoint", QVariant::fromValue(accessPointPath));
+                break;
+            }
+        }
+    }
+
+    uint oldState = property(devicePath, deviceInterface, "State").toUInt();
+    if (oldState != 100) {
+        setProperty(devicePath, deviceInterface, "State", 100u);
+        emitSignal(devicePath, deviceInterface, "StateChanged", {100u, oldState, 0u});
+    }
+
+    return path;
+}
+
+QVariant MockNetworkManager::property(const QString &path, const QString &interface, const QString &name) const
+{
+    return m_objects.value(path).value(interface).value(name);
+}
+
+void MockNetworkManager::setProperty(const QString &path, const QString &interface, const QString &name, const QVariant &value, bool notify)
+{
+    if (!m_objects.contains(path))
+        return;
+
+    m_objects[path][interface].insert(name, value);
+    if (notify) {
+        QVariantMap changedProperties;
+        changedProperties.insert(name, value);
+        emitSignal(path, propertiesInterface, "PropertiesChanged", {interface, changedProperties, QStringList()});
+    }
+}
+
+QList<QDBusObjectPath> MockNetworkManager::objectPaths(const QString &path, const QString &interface, const QString &name) const
+{
+    return qvariant_cast<QList<QDBusObjectPath>>(property(path, interface, name));
+}
+
+void MockNetworkManager::appendObjectPath(const QString &path, const QString &interface, const QString &name, const QString &objectPath)
+{
+    QList<QDBusObjectPath> paths = objectPaths(path, interface, name);
+    paths.append(QDBusObjectPath(objectPath));
+    setProperty(path, interface, name, QVariant::fromValue(paths));
+}
+
+void MockNetworkManager::removeObjectPath(const QString &path, const QString &interface, const QString &name, const QString &objectPath)
+{
+    QList<QDBusObjectPath> paths = objectPaths(path, interface, name);
+    paths.removeAll(QDBusObjectPath(objectPath));
+    setProperty(path, interface, name, QVariant::fromValue(paths));
+}
+
+void MockNetworkManager::emitSignal(const QString &path, const QString &interface, const QString &name, const QVariantList &arguments)
+{
+    // Note: nothing to emit before the service has been registered
+    if (!m_connection.isConnected())
+        return;
+
+    QDBusMessage signal = QDBusMessage::createSignal(path, interface, name);
+    signal.setArguments(arguments);
+    m_connection.send(signal);
+}
+
+void MockNetworkManager::sendReply(const QDBusMessage &message, const QVariantList &arguments)
+{
+    m_connection.send(message.createReply(arguments));
+}
+
+void MockNetworkManager::sendError(const QDBusMessage &message, const QString &name, const QString &text)
+{
+    m_connection.send(message.createErrorReply(name, text));
+}
+
+qint64 MockNetworkManager::bootTime()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    return static_cast<qint64>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+bool MockNetworkManager::handlePropertiesCall(const QDBusMessage &message)
+{
+    const QVariantList arguments = message.arguments();
+    if (arguments.isEmpty())
+        return false;
+
+    const QString interface = arguments.at(0).toString();
+    if (!m_objects.value(message.path()).contains(interface)) {
+        sendError(message, "org.freedesktop.DBus.Error.UnknownInterface", QString("No such interface %1 on %2").arg(interface, message.path()));
+        return true;
+    }
+
+    if (message.member() == "GetAll") {
+        sendReply(message, {m_objects.value(message.path()).value(interface)});
+        return true;
+    }
+
+    if (message.member() == "Get" && arguments.count() == 2) {
+        const QString name = arguments.at(1).toString();
+        if (!m_objects.value(message.path()).value(interface).contains(name)) {
+            sendError(message, "org.freedesktop.DBus.Error.UnknownProperty", QString("No such property %1").arg(name));
+            return true;
+        }
+
+        sendReply(message, {QVariant::fromValue(QDBusVariant(property(message.path(), interface, arguments.at(1).toString())))});
+        return true;
+    }
+
+    if (message.member() == "Set" && arguments.count() == 3) {
+        setProperty(message.path(), interface, arguments.at(1).toString(), qvariant_cast<QDBusVariant>(arguments.at(2)).variant());
+        sendReply(message);
+        return true;
+    }
+
+    return false;
+}
+
+bool MockNetworkManager::handleObjectManagerCall(const QDBusMessage &message)
+{
+    if (message.member() != "GetManagedObjects" || message.path() != NetworkManagerUtils::objectManagerPathString())
+        return false;
+
+    NMManagedObjects managedObjects;
+    foreach (const QString &path, m_objects.keys()) {
+        managedObjects.insert(QDBusObjectPath(path), m_objects.value(path));
+    }
+
+    sendReply(message, {QVariant::fromValue(managedObjects)});
+    return true;
+}
+
+bool MockNetworkManager::handleNetworkManagerCall(const QDBusMessage &message)
+{
+    const QVariantList arguments = message.arguments();
+    const QString managerPath = NetworkManagerUtils::networkManagerPathString();
+    const QString managerInterface = NetworkManagerUtils::networkManagerServiceString();
+
+    if (message.member() == "GetDevices" || message.member() == "GetAllDevices") {
+        sendReply(message, {property(managerPath, managerInterface, message.member() == "GetDevices" ? "Devices" : "AllDevices")});
+        return true;
+    }
+
+    if (message.member() == "CheckConnectivity") {
+        sendReply(message, {property(managerPath, managerInterface, "Connectivity")});
+        return true;
+    }
+
+    if (message.member() == "Enable" && arguments.count() == 1) {
+        setProperty(managerPath, managerInterface, "NetworkingEnabled", arguments.at(0).toBool());
+        sendReply(message);
+        return true;
+    }
+
+    if (message.member() == "ActivateConnection" && arguments.count() == 3) {
+        QString connectionPath = qvariant_cast<QDBusObjectPath>(arguments.at(0)).path();
+        QString devicePath = qvariant_cast<QDBusObjectPath>(arguments.at(1)).path();
+        if (!m_connectionSettings.contains(connectionPath) || !m_objects.contains(devicePath)) {
+            sendError(message, "org.freedesktop.NetworkManager.UnknownConnection", "Unknown connection or device");
+            return true;
+        }
+
+        sendReply(message, {QVariant::fromValue(QDBusObjectPath(activateConnection(connectionPath, devicePath)))});
+        return true;
+    }
+
+    if ((message.member() == "AddAndActivateConnection" && arguments.count() == 3) || (message.member() == "AddAndActivateConnection2" && arguments.count() == 4)) {
+        ConnectionSettings settings = qdbus_cast<ConnectionSettings>(arguments.at(0));
+        QString devicePath = qvariant_cast<QDBusObjectPath>(arguments.at(1)).path();
+        if (!m_objects.contains(devicePath)) {
+            sendError(message, "org.freedesktop.NetworkManager.UnknownDevice", "Unknown device");
+            return true;
+        }
+
+        bool unsaved = false;
+        if (arguments.count() == 4)
+            unsaved = qdbus_cast<QVariantMap>(arguments.at(3)).value("persist").toString() != "disk";
+
+        QString connectionPath = addConnection(settings, unsaved);
+        QString activeConnectionPath = activateConnection(connectionPath, devicePath);
+
+        QVariantList replyArguments = {QVariant::fromValue(QDBusObjectPath(connectionPath)), QVariant::fromValue(QDBusObjectPath(activeConnectionPath))};
+        if (arguments.count() == 4)
+            replyArguments.append(QVariantMap());
+
+        sendReply(message, replyArguments);
+        return true;
+    }
+
+    if (message.member() == "DeactivateConnection" && arguments.count() == 1) {
+        QString activeConnectionPath = qvariant_cast<QDBusObjectPath>(arguments.at(0)).path();
+        if (!m_objects.value(activeConnectionPath).contains(activeConnectionInterface)) {
+            sendError(message, "org.freedesktop.NetworkManager.ConnectionNotActive", "Connection not active");
+            return true;
+        }
+
+        m_objects.remove(activeConnectionPath);
+        removeObjectPath(managerPath, managerInterface, "ActiveConnections", activeConnectionPath);
+        sendReply(message);
+        return true;
+    }
+
+    return false;
+}
+
+bool MockNetworkManager::handleSettingsCall(const QDBusMessage &message)
+{
+    const QVariantList arguments = message.arguments();
+
+    if (message.member() == "ListConnections") {
+        sendReply(message, {property(NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), "Connections")});
+        return true;
+    }
+
+    if ((message.member() == "AddConnection" || message.member() == "AddConnectionUnsaved") && arguments.count() == 1) {
+        QString path = addConnection(qdbus_cast<ConnectionSettings>(arguments.at(0)), message.member() == "AddConnectionUnsaved");
+        sendReply(message, {QVariant::fromValue(QDBusObjectPath(path))});
+        return true;
+    }
+
+    if (message.member() == "AddConnection2" && arguments.count() == 3) {
+        // NM_SETTINGS_ADD_CONNECTION2_FLAG_IN_MEMORY = 0x2
+        bool unsaved = arguments.at(1).toUInt() & 0x2;
+        QString path = addConnection(qdbus_cast<ConnectionSettings>(arguments.at(0)), unsaved);
+        sendReply(message, {QVariant::fromValue(QDBusObjectPath(path)), QVariantMap()});
+        return true;
+    }
+
+    if (message.member() == "GetConnectionByUuid" && arguments.count() == 1) {
+        foreach (const QString &path, m_connectionSettings.keys()) {
+            if (m_connectionSettings.value(path).value("connection").value("uuid").toString() == arguments.at(0).toString()) {
+                sendReply(message, {QVariant::fromValue(QDBusObjectPath(path))});
+                return true;
+            }
+        }
+
+        sendError(message, "org.freedesktop.NetworkManager.Settings.InvalidConnection", "No connection with this UUID");
+        return true;
+    }
+
+    return false;
+}
+
+bool MockNetworkManager::handleConnectionCall(const QDBusMessage &message)
+{
+    const QVariantList arguments = message.arguments();
+    if (!m_connectionSettings.contains(message.path())) {
+        sendError(message, "org.freedesktop.DBus.Error.UnknownObject", QString("No such connection %1").arg(message.path()));
+        return true;
+    }
+
+    if (message.member() == "GetSettings") {
+        sendReply(message, {QVariant::fromValue(m_connectionSettings.value(message.path()))});
+        return true;
+    }
+
+    if (message.member() == "Delete") {
+        removeConnection(message.path());
+        sendReply(message);
+        return true;
+    }
+
+    if (message.member() == "Save") {
+        setProperty(message.path(), NetworkManagerUtils::connectionsInterfaceString(), "Unsaved", false);
+        sendReply(message);
+        return true;
+    }
+
+    if ((message.member() == "Update" || message.member() == "UpdateUnsaved" || message.member() == "Update2") && !arguments.isEmpty()) {
+        ConnectionSettings settings = qdbus_cast<ConnectionSettings>(arguments.at(0));
+        if (!settings.isEmpty())
+            m_connectionSettings.insert(message.path(), settings);
+
+        bool unsaved = message.member() == "UpdateUnsaved";
+        if (message.member() == "Update2" && arguments.count() == 3) {
+            // NM_SETTINGS_UPDATE2_FLAG_TO_DISK = 0x1, IN_MEMORY = 0x2
+            unsaved = !(arguments.at(1).toUInt() & 0x1) && (arguments.at(1).toUInt() & 0x2);
+        }
+
+        setProperty(message.path(), NetworkManagerUtils::connectionsInterfaceString(), "Unsaved", unsaved);
+        emitSignal(message.path(), NetworkManagerUtils::connectionsInterfaceString(), "Updated", QVariantList());
+
+        if (message.member() == "Update2") {
+            sendReply(message, {QVariantMap()});
+        } else {
+            sendReply(message);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool MockNetworkManager::handleDeviceCall(const QDBusMessage &message)
+{
+    const QString deviceInterface = NetworkManagerUtils::deviceInterfaceString();
+    if (!m_objects.value(message.path()).contains(deviceInterface))
+        return false;
+
+    if (message.member() == "Disconnect") {
+        uint oldState = property(message.path(), deviceInterface, "State").toUInt();
+        setProperty(message.path(), deviceInterface, "ActiveConnection", QVariant::fromValue(QDBusObjectPath("/")));
+        if (m_objects.value(message.path()).contains(NetworkManagerUtils::wirelessInterfaceString()))
+            setProperty(message.path(), NetworkManagerUtils::wirelessInterfaceString(), "ActiveAccessPoint", QVariant::fromValue(QDBusObjectPath("/")));
+
+        setProperty(message.path(), deviceInterface, "State", 30u);
+        emitSignal(message.path(), deviceInterface, "StateChanged", {30u, oldState, 39u});
+        sendReply(message);
+        return true;
+    }
+
+    return false;
+}
+
+bool MockNetworkManager::handleWirelessCall(const QDBusMessage &message)
+{
+    const QString wirelessInterface = NetworkManagerUtils::wirelessInterfaceString();
+    if (!m_objects.value(message.path()).contains(wirelessInterface))
+        return false;
+
+    if (message.member() == "GetAccessPoints" || message.member() == "GetAllAccessPoints") {
+        sendReply(message, {property(message.path(), wirelessInterface, "AccessPoints")});
+        return true;
+    }
+
+    if (message.member() == "RequestScan") {
+        sendReply(message);
+
+        // Finish the scan like the real NetworkManager by updating LastScan
+        QString path = message.path();
+        QTimer::singleShot(100, this, [this, path, wirelessInterface](){
+            setProperty(path, wirelessInterface, "LastScan", bootTime());
+        });
+        return true;
+    }
+
+    return false;
+}
+
+bool MockNetworkManager::handleBenchmarkCall(const QDBusMessage &message)
+{
+    const QVariantList arguments = message.arguments();
+    if (message.path() != benchmarkPathString() || arguments.count() != 1)
+        return false;
+
+    const int count = arguments.at(0).toInt();
+
+    // Adds count new access points to every wireless device
+    if (message.member() == "AddAccessPoints") {
+        QList<QDBusObjectPath> added;
+        foreach (const QString &path, m_objects.keys()) {
+            if (!m_objects.value(path).contains(NetworkManagerUtils::wirelessInterfaceString()))
+                continue;
+
+            for (int i = 0; i < count; i++) {
+                added.append(QDBusObjectPath(addAccessPoint(path)));
+            }
+        }
+
+        sendReply(message, {QVariant::fromValue(added)});
+        return true;
+    }
+
+    // Replaces the count oldest access points of every wireless device, one by one
+    if (message.member() == "ChurnAccessPoints") {
+        QList<QDBusObjectPath> added;
+        QList<QDBusObjectPath> removed;
+        foreach (const QString &path, m_objects.keys()) {
+            if (!m_objects.value(path).contains(NetworkManagerUtils::wirelessInterfaceString()))
+                continue;
+
+            for (int i = 0; i < count; i++) {
+                QList<QDBusObjectPath> accessPoints = objectPaths(path, NetworkManagerUtils::wirelessInterfaceString(), "AccessPoints");
+                if (!accessPoints.isEmpty() && removeAccessPoint(accessPoints.first().path()))
+                    removed.append(accessPoints.first());
+
+                added.append(QDBusObjectPath(addAccessPoint(path)));
+            }
+        }
+
+        sendReply(message, {QVariant::fromValue(added), QVariant::fromValue(removed)});
+        return true;
+    }
+
+    return false;
+}
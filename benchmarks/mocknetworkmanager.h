@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef MOCKNETWORKMANAGER_H
+#define MOCKNETWORKMANAGER_H
+
+#include <QObject>
+#include <QDBusMessage>
+#include <QDBusConnection>
+#include <QDBusObjectPath>
+#include <QDBusVirtualObject>
+
+#include "networkconnection.h"
+#include "networkmanagerutils.h"
+
+class MockNetworkManager : public QDBusVirtualObject
+{
+    Q_OBJECT
+public:
+    struct Configuration {
+        int wirelessDevices = 1;
+        int wiredDevices = 1;
+        int accessPoints = 50;
+        int connections = 10;
+    };
+
+    explicit MockNetworkManager(const Configuration &configuration, QObject *parent = nullptr);
+
+    bool registerService(const QDBusConnection &connection);
+
+    QString introspect(const QString &path) const override;
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override;
+
+    static QString benchmarkPathString();
+    static QString benchmarkInterfaceString();
+
+private:
+    QDBusConnection m_connection;
+    Configuration m_configuration;
+
+    // Object path -> interface -> properties
+    QMap<QString, NMInterfacesMap> m_objects;
+    QHash<QString, ConnectionSettings> m_connectionSettings;
+    QHash<QString, QString> m_accessPointDevices;
+
+    int m_deviceCounter = 0;
+    int m_accessPointCounter = 0;
+    int m_connectionCounter = 0;
+    int m_activeConnectionCounter = 0;
+
+    // Object model
+    QString addDevice(uint deviceType, const QString &interface);
+    QString addAccessPoint(const QString &devicePath);
+    bool removeAccessPoint(const QString &accessPointPath);
+    QString addConnection(const ConnectionSettings &settings, bool unsaved = false);
+    bool removeConnection(const QString &connectionPath);
+    QString activateConnection(const QString &connectionPath, const QString &devicePath);
+
+    QVariant property(const QString &path, const QString &interface, const QString &name) const;
+    void setProperty(const QString &path, const QString &interface, const QString &name, const QVariant &value, bool notify = true);
+    QList<QDBusObjectPath> objectPaths(const QString &path, const QString &interface, const QString &name) const;
+    void appendObjectPath(const QString &path, const QString &interface, const QString &name, const QString &objectPath);
+    void removeObjectPath(const QString &path, const QString &interface, const QString &name, const QString &objectPath);
+
+    void emitSignal(const QString &path, const QString &interface, const QString &name, const QVariantList &arguments);
+    void sendReply(const QDBusMessage &message, const QVariantList &arguments = QVariantList());
+    void sendError(const QDBusMessage &message, const QString &name, const QString &text);
+
+    static qint64 bootTime();
+
+    // Method handlers
+    bool handlePropertiesCall(const QDBusMessage &message);
+    bool handleObjectManagerCall(const QDBusMessage &message);
+    bool handleNetworkManagerCall(const QDBusMessage &message);
+    bool handleSettingsCall(const QDBusMessage &message);
+    bool handleConnectionCall(const QDBusMessage &message);
+    bool handleDeviceCall(const QDBusMessage &message);
+    bool handleWirelessCall(const QDBusMessage &message);
+    bool handleBenchmarkCall(const QDBusMessage &message);
+
+};
+
+#endif // MOCKNETWORKMANAGER_H
@@ -0,0 +1,376 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "networkmanagerbenchmark.h"
+#include "networkmanager.h"
+
+#include <algorithm>
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QTimer>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QDBusConnectionInterface>
+
+NetworkManagerBenchmark::NetworkManagerBenchmark(const MockNetworkManager::Configuration &configuration, int iterations, int churn, QObject *parent) :
+    QObject(parent),
+    m_configuration(configuration),
+    m_iterations(qMax(1, iterations)),
+    m_churn(qMax(1, churn))
+{
+
+}
+
+NetworkManagerBenchmark::~NetworkManagerBenchmark()
+{
+    stopProcesses();
+}
+
+int NetworkManagerBenchmark::run()
+{
+    QTextStream out(stdout);
+    out << "Mock NetworkManager: " << m_configuration.wirelessDevices << " wireless devices, "
+        << m_configuration.wiredDevices << " wired devices, "
+        << m_configuration.accessPoints << " access points per wireless device, "
+        << m_configuration.connections << " connections\n";
+
+    if (!startBus() || !startMock()) {
+        stopProcesses();
+        return 1;
+    }
+
+    bool success = benchmarkInit();
+
+    NetworkManager *networkManager = nullptr;
+    if (success) {
+        networkManager = createNetworkManager();
+        success = networkManager != nullptr;
+    }
+
+    if (success)
+        success = benchmarkConnectWifi(networkManager);
+
+    if (success)
+        success = benchmarkAccessPointChurn(networkManager);
+
+    if (success)
+        success = benchmarkAccessPointMemory(networkManager);
+
+    delete networkManager;
+    stopProcesses();
+    return success ? 0 : 1;
+}
+
+bool NetworkManagerBenchmark::startBus()
+{
+    m_busProcess = new QProcess(this);
+    m_busProcess->start("dbus-daemon", {"--session", "--nofork", "--print-address"});
+    if (!m_busProcess->waitForStarted(5000)) {
+        qWarning() << "Could not start dbus-daemon:" << m_busProcess->errorString();
+        return false;
+    }
+
+    while (!m_busProcess->canReadLine()) {
+        if (!m_busProcess->waitForReadyRead(5000)) {
+            qWarning() << "The dbus-daemon did not report its address.";
+            return false;
+        }
+    }
+
+    // Note: must happen before the first use of QDBusConnection::systemBus()
+    QByteArray address = m_busProcess->readLine().trimmed();
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", address);
+    return true;
+}
+
+bool NetworkManagerBenchmark::startMock()
+{
+    QStringList arguments;
+    arguments << "--mock";
+    arguments << "--wireless-devices" << QString::number(m_configuration.wirelessDevices);
+    arguments << "--wired-devices" << QString::number(m_configuration.wiredDevices);
+    arguments << "--access-points" << QString::number(m_configuration.accessPoints);
+    arguments << "--connections" << QString::number(m_configuration.connections);
+
+    m_mockProcess = new QProcess(this);
+    m_mockProcess->setProcessChannelMode(QProcess::ForwardedChannels);
+    m_mockProcess->start(QCoreApplication::applicationFilePath(), arguments);
+    if (!m_mockProcess->waitForStarted(5000)) {
+        qWarning() << "Could not start the mock NetworkManager:" << m_mockProcess->errorString();
+        return false;
+    }
+
+    bool registered = waitFor([](){
+        return QDBusConnection::systemBus().interface()->isServiceRegistered(NetworkManagerUtils::networkManagerServiceString()).value();
+    });
+
+    if (!registered)
+        qWarning() << "The mock NetworkManager did not appear on the bus.";
+
+    return registered;
+}
+
+void NetworkManagerBenchmark::stopProcesses()
+{
+    foreach (QProcess *process, QList<QProcess *>() << m_mockProcess << m_busProcess) {
+        if (!process || process->state() == QProcess::NotRunning)
+            continue;
+
+        process->terminate();
+        if (!process->waitForFinished(3000))
+            process->kill();
+    }
+}
+
+NetworkManager *NetworkManagerBenchmark::createNetworkManager()
+{
+    const int expectedAccessPoints = m_configuration.wirelessDevices * m_configuration.accessPoints;
+
+    NetworkManager *networkManager = new NetworkManager(this);
+    networkManager->start();
+    bool ready = waitFor([this, networkManager, expectedAccessPoints](){
+        return networkManager->available() && accessPointCount(networkManager) == expectedAccessPoints;
+    });
+
+    if (!ready) {
+        qWarning() << "The NetworkManager did not finish initializing.";
+        delete networkManager;
+        return nullptr;
+    }
+
+    return networkManager;
+}
+
+int NetworkManagerBenchmark::accessPointCount(NetworkManager *networkManager) const
+{
+    int count = 0;
+    foreach (WirelessNetworkDevice *wirelessNetworkDevice, networkManager->wirelessNetworkDevices()) {
+        count += wirelessNetworkDevice->accessPoints().count();
+    }
+    return count;
+}
+
+bool NetworkManagerBenchmark::benchmarkInit()
+{
+    QList<double> samples;
+    for (int i = 0; i < m_iterations; i++) {
+        QElapsedTimer timer;
+        timer.start();
+        NetworkManager *networkManager = createNetworkManager();
+        if (!networkManager)
+            return false;
+
+        samples.append(timer.nsecsElapsed() / 1000000.0);
+        delete networkManager;
+    }
+
+    printResult("init", samples, "ms");
+    return true;
+}
+
+bool NetworkManagerBenchmark::benchmarkConnectWifi(NetworkManager *networkManager)
+{
+    if (networkManager->wirelessNetworkDevices().isEmpty() || networkManager->wirelessNetworkDevices().first()->accessPoints().isEmpty()) {
+        QTextStream(stdout) << "connectWifi: skipped, no access points\n";
+        return true;
+    }
+
+    WirelessNetworkDevice *wirelessNetworkDevice = networkManager->wirelessNetworkDevices().first();
+    const QString ssid = wirelessNetworkDevice->accessPoints().first()->ssid();
+
+    QList<double> samples;
+    for (int i = 0; i < m_iterations; i++) {
+        QElapsedTimer timer;
+        timer.start();
+        NetworkManager::NetworkManagerError error = networkManager->connectWifi(wirelessNetworkDevice->interface(), ssid, "benchmark");
+        samples.append(timer.nsecsElapsed() / 1000000.0);
+        if (error != NetworkManager::NetworkManagerErrorNoError) {
+            qWarning() << "connectWifi failed:" << error;
+            return false;
+        }
+
+        // Let the library process the resulting signals before the next round
+        waitFor([](){ return true; }, 0);
+    }
+
+    printResult("connectWifi", samples, "ms");
+    return true;
+}
+
+bool NetworkManagerBenchmark::benchmarkAccessPointChurn(NetworkManager *networkManager)
+{
+    if (networkManager->wirelessNetworkDevices().isEmpty()) {
+        QTextStream(stdout) << "access point churn: skipped, no wireless devices\n";
+        return true;
+    }
+
+    QList<double> samples;
+    for (int i = 0; i < m_iterations; i++) {
+        QElapsedTimer timer;
+        timer.start();
+
+        QDBusMessage call = QDBusMessage::createMethodCall(NetworkManagerUtils::networkManagerServiceString(), MockNetworkManager::benchmarkPathString(), MockNetworkManager::benchmarkInterfaceString(), "ChurnAccessPoints");
+        call << m_churn;
+        QDBusMessage reply = QDBusConnection::systemBus().call(call);
+        if (reply.type() != QDBusMessage::ReplyMessage || reply.arguments().count() != 2) {
+            qWarning() << "Could not churn access points:" << reply.errorMessage();
+            return false;
+        }
+
+        const QList<QDBusObjectPath> added = qdbus_cast<QList<QDBusObjectPath>>(reply.arguments().at(0));
+        const QList<QDBusObjectPath> removed = qdbus_cast<QList<QDBusObjectPath>>(reply.arguments().at(1));
+        bool converged = waitFor([networkManager, added, removed](){
+            foreach (WirelessNetworkDevice *wirelessNetworkDevice, networkManager->wirelessNetworkDevices()) {
+                foreach (const QDBusObjectPath &objectPath, removed) {
+                    if (wirelessNetworkDevice->getAccessPoint(objectPath))
+                        return false;
+                }
+            }
+
+            foreach (const QDBusObjectPath &objectPath, added) {
+                bool found = false;
+                foreach (WirelessNetworkDevice *wirelessNetworkDevice, networkManager->wirelessNetworkDevices()) {
+                    if (wirelessNetworkDevice->getAccessPoint(objectPath)) {
+                        found = true;
+                        break;
+                    }
+                }
+
+                if (!found)
+                    return false;
+            }
+            return true;
+        });
+
+        if (!converged) {
+            qWarning() << "The access point list did not converge.";
+            return false;
+        }
+
+        samples.append((added.count() + removed.count()) / (timer.nsecsElapsed() / 1000000000.0));
+    }
+
+    printResult("access point churn", samples, "events/s");
+    return true;
+}
+
+bool NetworkManagerBenchmark::benchmarkAccessPointMemory(NetworkManager *networkManager)
+{
+    if (networkManager->wirelessNetworkDevices().isEmpty() || m_configuration.accessPoints <= 0) {
+        QTextStream(stdout) << "memory per access point: skipped, no wireless devices\n";
+        return true;
+    }
+
+    // Settle pending deletions and messages first
+    waitFor([](){ return true; }, 0);
+    const int countBefore = accessPointCount(networkManager);
+    const qint64 heapBefore = heapUsage();
+
+    QDBusMessage call = QDBusMessage::createMethodCall(NetworkManagerUtils::networkManagerServiceString(), MockNetworkManager::benchmarkPathString(), MockNetworkManager::benchmarkInterfaceString(), "AddAccessPoints");
+    call << m_configuration.accessPoints;
+    QDBusMessage reply = QDBusConnection::systemBus().call(call);
+    if (reply.type() != QDBusMessage::ReplyMessage || reply.arguments().count() != 1) {
+        qWarning() << "Could not add access points:" << reply.errorMessage();
+        return false;
+    }
+
+    const int added = qdbus_cast<QList<QDBusObjectPath>>(reply.arguments().at(0)).count();
+    bool loaded = waitFor([this, networkManager, countBefore, added](){
+        return accessPointCount(networkManager) == countBefore + added;
+    });
+
+    if (!loaded || added == 0) {
+        qWarning() << "The added access points have not been loaded.";
+        return false;
+    }
+
+    waitFor([](){ return true; }, 0);
+    const qint64 heapAfter = heapUsage();
+
+    printResult("memory per access point", QList<double>() << static_cast<double>(heapAfter - heapBefore) / added, "bytes");
+    return true;
+}
+
+bool NetworkManagerBenchmark::waitFor(const std::function<bool()> &condition, int timeout)
+{
+    QEventLoop loop;
+    QTimer pollTimer;
+    pollTimer.setInterval(1);
+    connect(&pollTimer, &QTimer::timeout, &loop, [&loop, &condition](){
+        if (condition())
+            loop.quit();
+    });
+
+    QTimer timeoutTimer;
+    timeoutTimer.setSingleShot(true);
+    connect(&timeoutTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
+
+    pollTimer.start();
+    timeoutTimer.start(qMax(timeout, 1));
+    loop.exec();
+
+    return condition();
+}
+
+qint64 NetworkManagerBenchmark::heapUsage()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return static_cast<qint64>(mallinfo2().uordblks);
+#elif defined(__GLIBC__)
+    return static_cast<qint64>(mallinfo().uordblks);
+#else
+    // Fall back to the resident set size
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+
+    QList<QByteArray> values = statm.readAll().split(' ');
+    return values.count() > 1 ? values.at(1).toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
+
+void NetworkManagerBenchmark::printResult(const QString &name, QList<double> samples, const QString &unit)
+{
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0;
+    foreach (double sample, samples) {
+        sum += sample;
+    }
+
+    QTextStream out(stdout);
+    out << QString("%1 samples %2  min %3  median %4  mean %5  max %6 %7")
+           .arg(name + ":", -26)
+           .arg(samples.count(), 4)
+           .arg(samples.first(), 0, 'f', 2)
+           .arg(samples.at(samples.count() / 2), 0, 'f', 2)
+           .arg(sum / samples.count(), 0, 'f', 2)
+           .arg(samples.last(), 0, 'f', 2)
+           .arg(unit) << "\n";
+}
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef NETWORKMANAGERBENCHMARK_H
+#define NETWORKMANAGERBENCHMARK_H
+
+#include <functional>
+
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+
+#include "mocknetworkmanager.h"
+
+class NetworkManager;
+
+class NetworkManagerBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit NetworkManagerBenchmark(const MockNetworkManager::Configuration &configuration, int iterations, int churn, QObject *parent = nullptr);
+    ~NetworkManagerBenchmark();
+
+    int run();
+
+private:
+    MockNetworkManager::Configuration m_configuration;
+    int m_iterations = 10;
+    int m_churn = 50;
+
+    QProcess *m_busProcess = nullptr;
+    QProcess *m_mockProcess = nullptr;
+
+    bool startBus();
+    bool startMock();
+    void stopProcesses();
+
+    NetworkManager *createNetworkManager();
+    int accessPointCount(NetworkManager *networkManager) const;
+
+    bool benchmarkInit();
+    bool benchmarkConnectWifi(NetworkManager *networkManager);
+    bool benchmarkAccessPointChurn(NetworkManager *networkManager);
+    bool benchmarkAccessPointMemory(NetworkManager *networkManager);
+
+    static bool waitFor(const std::function<bool()> &condition, int timeout = 10000);
+    static qint64 heapUsage();
+    static void printResult(const QString &name, QList<double> samples, const QString &unit);
+
+};
+
+#endif // NETWORKMANAGERBENCHMARK_H
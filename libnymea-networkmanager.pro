@@ -1,4 +1,7 @@
 TEMPLATE = subdirs
-SUBDIRS += libnymea-networkmanager
+SUBDIRS += libnymea-networkmanager benchmarks tests
+
+benchmarks.depends = libnymea-networkmanager
+tests.depends = libnymea-networkmanager
 
 VERSION_STRING=$$system('dpkg-parsechangelog | sed -n -e "s/^Version: //p"')
@@ -367,6 +367,10 @@ void BluetoothServer::onConnected()
 {
     qCDebug(dcNetworkManagerBluetoothServer()) << "Client connected" << m_controller->remoteName() << m_controller->remoteAddress();
     setConnected(true);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5,14,0)
+    onMtuChanged(m_controller->mtu());
+#endif
 }
 
 void BluetoothServer::onDisconnected()
@@ -376,6 +380,14 @@ void BluetoothServer::onDisconnected()
     stop();
 }
 
+void BluetoothServer::onMtuChanged(int mtu)
+{
+    qCDebug(dcNetworkManagerBluetoothServer()) << "ATT MTU changed to" << mtu;
+    if (m_wirelessService) {
+        m_wirelessService->setMtu(mtu);
+    }
+}
+
 void BluetoothServer::onControllerStateChanged(QLowEnergyController::ControllerState state)
 {
     switch (state) {
@@ -509,6 +521,11 @@ void BluetoothServer::start()
             (&QLowEnergyController::error), this, &BluetoothServer::onError);
 #endif
 
+#if QT_VERSION >= QT_VERSION_CHECK(5,14,0)
+    // Note: clients which do not negotiate the MTU will use the default of 23 bytes
+    connect(m_controller, &QLowEnergyController::mtuChanged, this, &BluetoothServer::onMtuChanged);
+#endif
+
     // Note: https://www.bluetooth.com/specifications/gatt/services
     m_deviceInfoService = m_controller->addService(deviceInformationServiceData(), m_controller);
 #if QT_VERSION < QT_VERSION_CHECK(6,0,0)
@@ -565,6 +582,9 @@ void BluetoothServer::stop()
         m_controller->stopAdvertising();
         m_controller->deleteLater();
         m_controller = nullptr;
+        // Note: the services are owned by the controller
+        m_networkService = nullptr;
+        m_wirelessService = nullptr;
     }
 
     if (m_localDevice) {
@@ -119,6 +119,7 @@ private slots:
     void onConnected();
     void onDisconnected();
     void onControllerStateChanged(QLowEnergyController::ControllerState state);
+    void onMtuChanged(int mtu);
 
     // Services
     void characteristicChanged(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
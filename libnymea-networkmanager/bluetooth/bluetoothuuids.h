@@ -40,5 +40,6 @@ static QBluetoothUuid wirelessResponseCharacteristicUuid =  QBluetoothUuid(QUuid
 static QBluetoothUuid wirelessStateCharacteristicUuid =     QBluetoothUuid(QUuid("e081fec3-f757-4449-b9c9-bfa83133f7fc"));
 static QBluetoothUuid wirelessModeCharacteristicUuid =      QBluetoothUuid(QUuid("e081fec4-f757-4449-b9c9-bfa83133f7fc"));
 static QBluetoothUuid wirelessServiceVersionCharacteristicUuid = QBluetoothUuid(QUuid("e081fec5-f757-4449-b9c9-bfa83133f7fc"));
+static QBluetoothUuid wirelessNetworkEventsCharacteristicUuid = QBluetoothUuid(QUuid("e081fec6-f757-4449-b9c9-bfa83133f7fc"));
 
 #endif // BLUETOOTHUUIDS_H
@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*!
+    \class TransmitQueue
+    \brief Sends data as flow-controlled notifications on a bluetooth LE characteristic.
+    \inmodule nymea-networkmanager
+    \ingroup networkmanager-bluetooth
+
+    Writing notifications faster than the bluetooth controller is able to send them makes the
+    stack silently drop packages. The \l{TransmitQueue} splits the queued messages into packages
+    and writes at most one window of packages per pacing interval, which should match roughly the
+    connection interval of the link.
+
+    \note On a peripheral the characteristicWritten() signal only reports the changed local value,
+    not the notification being sent by the controller, so it can not be used to return credits.
+
+*/
+
+/*! \fn void TransmitQueue::queueDepthChanged(int queueDepth);
+    This signal will be emitted whenever the number of packages waiting to be sent changed to \a queueDepth.
+*/
+
+/*! \fn void TransmitQueue::messageSent(int tag);
+    This signal will be emitted when the last package of a message with the given \a tag has been handed to the bluetooth stack.
+*/
+
+#include "transmitqueue.h"
+#include "../networkmanagerutils.h"
+
+/*! Constructs a new \l{TransmitQueue} sending notifications on the characteristic with the given \a characteristicUuid of the \a service with the given \a parent. */
+TransmitQueue::TransmitQueue(QLowEnergyService *service, const QBluetoothUuid &characteristicUuid, QObject *parent) :
+    QObject(parent),
+    m_service(service),
+    m_characteristicUuid(characteristicUuid)
+{
+    m_pacingTimer = new QTimer(this);
+    m_pacingTimer->setInterval(20);
+    m_pacingTimer->setSingleShot(false);
+    connect(m_pacingTimer, &QTimer::timeout, this, &TransmitQueue::onPacingTimeout);
+}
+
+/*! Returns the maximum size of a single package in bytes. */
+int TransmitQueue::packageSize() const
+{
+    return m_packageSize;
+}
+
+/*! Sets the maximum size of a single package to \a packageSize bytes. This applies to messages queued afterwards. */
+void TransmitQueue::setPackageSize(int packageSize)
+{
+    m_packageSize = qMax(1, packageSize);
+}
+
+/*! Returns the maximum number of packages written to the bluetooth stack within one pacing interval. */
+int TransmitQueue::windowSize() const
+{
+    return m_windowSize;
+}
+
+/*! Sets the maximum number of packages written to the bluetooth stack within one pacing interval to \a windowSize. */
+void TransmitQueue::setWindowSize(int windowSize)
+{
+    m_windowSize = qMax(1, windowSize);
+    m_credits = qMin(m_credits, m_windowSize);
+}
+
+/*! Returns the interval in milliseconds in which the send window gets refilled. */
+int TransmitQueue::interval() const
+{
+    return m_pacingTimer->interval();
+}
+
+/*! Sets the \a interval in milliseconds in which the send window gets refilled. */
+void TransmitQueue::setInterval(int interval)
+{
+    m_pacingTimer->setInterval(qMax(1, interval));
+}
+
+/*! Returns the given \a data split into packages of the current package size. */
+QList<QByteArray> TransmitQueue::createPackages(const QByteArray &data) const
+{
+    QList<QByteArray> packages;
+    packages.reserve((data.length() + m_packageSize - 1) / m_packageSize);
+    for (int offset = 0; offset < data.length(); offset += m_packageSize) {
+        packages.append(data.mid(offset, m_packageSize));
+    }
+    return packages;
+}
+
+/*! Queues the given \a data for sending.
+
+    If \a tag is not negative, queued messages with the same \a tag which have not started sending yet
+    are stale and get cancelled. If \a preempt is true, the message will be sent right after the message
+    currently being transmitted instead of at the end of the queue.
+*/
+void TransmitQueue::enqueue(const QByteArray &data, int tag, bool preempt)
+{
+    enqueuePackages(createPackages(data), tag, preempt);
+}
+
+/*! Queues the already split \a packages of a message for sending. This allows to send prebuilt messages repeatedly without copying them.
+
+    The \a tag and \a preempt parameters behave like in enqueue().
+
+    \sa createPackages()
+*/
+void TransmitQueue::enqueuePackages(const QList<QByteArray> &packages, int tag, bool preempt)
+{
+    if (packages.isEmpty())
+        return;
+
+    if (tag >= 0)
+        cancelMessages(tag);
+
+    Message message;
+    message.packages = packages;
+    message.tag = tag;
+
+    if (m_messages.isEmpty()) {
+        m_transmissionTimer.start();
+        m_messages.append(message);
+    } else if (preempt) {
+        // Never interrupt a message in transmission, the receiver would not be able to reassemble it
+        m_messages.insert(m_messages.first().index > 0 ? 1 : 0, message);
+    } else {
+        m_messages.append(message);
+    }
+
+    emit queueDepthChanged(queueDepth());
+    sendPackages();
+}
+
+/*! Drops all queued data, i.e. if the remote device disconnected. */
+void TransmitQueue::clear()
+{
+    if (m_messages.isEmpty())
+        return;
+
+    m_cancelledMessages += m_messages.count();
+    m_messages.clear();
+    m_transmissionTime += m_transmissionTimer.elapsed();
+    emit queueDepthChanged(0);
+}
+
+/*! Returns the number of packages waiting to be sent. */
+int TransmitQueue::queueDepth() const
+{
+    int depth = 0;
+    foreach (const Message &message, m_messages) {
+        depth += message.packages.count() - message.index;
+    }
+    return depth;
+}
+
+/*! Returns the number of messages waiting to be sent completely. */
+int TransmitQueue::pendingMessages() const
+{
+    return m_messages.count();
+}
+
+/*! Returns the total number of bytes sent. */
+quint64 TransmitQueue::bytesSent() const
+{
+    return m_bytesSent;
+}
+
+/*! Returns the total number of packages sent. */
+quint64 TransmitQueue::packagesSent() const
+{
+    return m_packagesSent;
+}
+
+/*! Returns the total number of messages which have been cancelled before they were sent completely. */
+quint64 TransmitQueue::cancelledMessages() const
+{
+    return m_cancelledMessages;
+}
+
+/*! Returns the average throughput in bytes per second while data was waiting to be sent. */
+double TransmitQueue::throughput() const
+{
+    qint64 transmissionTime = m_transmissionTime;
+    if (!m_messages.isEmpty())
+        transmissionTime += m_transmissionTimer.elapsed();
+
+    if (transmissionTime <= 0)
+        return 0;
+
+    return m_bytesSent * 1000.0 / transmissionTime;
+}
+
+void TransmitQueue::onPacingTimeout()
+{
+    m_credits = m_windowSize;
+
+    // Note: keep running for one interval after the queue drained, so the next message can not overrun the last window
+    if (m_messages.isEmpty()) {
+        m_pacingTimer->stop();
+        return;
+    }
+
+    sendPackages();
+}
+
+void TransmitQueue::cancelMessages(int tag)
+{
+    for (int i = m_messages.count() - 1; i >= 0; i--) {
+        const Message &message = m_messages.at(i);
+        if (message.tag != tag || message.index > 0)
+            continue;
+
+        qCDebug(dcNetworkManagerBluetoothServer()) << "TransmitQueue: Cancel stale message" << tag << "(" << message.packages.count() << "packages )";
+        m_messages.removeAt(i);
+        m_cancelledMessages++;
+    }
+}
+
+void TransmitQueue::sendPackages()
+{
+    if (m_messages.isEmpty())
+        return;
+
+    QLowEnergyCharacteristic characteristic = m_service->characteristic(m_characteristicUuid);
+    if (!characteristic.isValid()) {
+        qCWarning(dcNetworkManagerBluetoothServer()) << "TransmitQueue: Characteristic not valid. Dropping queued data.";
+        clear();
+        return;
+    }
+
+    QList<int> sentTags;
+    while (m_credits > 0 && !m_messages.isEmpty()) {
+        Message &message = m_messages.first();
+        const QByteArray &package = message.packages.at(message.index++);
+        m_service->writeCharacteristic(characteristic, package);
+        m_bytesSent += package.length();
+        m_packagesSent++;
+        m_credits--;
+
+        if (message.index >= message.packages.count()) {
+            sentTags.append(message.tag);
+            m_messages.removeFirst();
+        }
+    }
+
+    if (m_messages.isEmpty())
+        m_transmissionTime += m_transmissionTimer.elapsed();
+
+    if (!m_pacingTimer->isActive())
+        m_pacingTimer->start();
+
+    emit queueDepthChanged(queueDepth());
+
+    foreach (int tag, sentTags) {
+        emit messageSent(tag);
+    }
+}
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TRANSMITQUEUE_H
+#define TRANSMITQUEUE_H
+
+#include <QList>
+#include <QTimer>
+#include <QObject>
+#include <QElapsedTimer>
+#include <QBluetoothUuid>
+#include <QLowEnergyService>
+
+class TransmitQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TransmitQueue(QLowEnergyService *service, const QBluetoothUuid &characteristicUuid, QObject *parent = nullptr);
+
+    int packageSize() const;
+    void setPackageSize(int packageSize);
+
+    int windowSize() const;
+    void setWindowSize(int windowSize);
+
+    int interval() const;
+    void setInterval(int interval);
+
+    QList<QByteArray> createPackages(const QByteArray &data) const;
+
+    void enqueue(const QByteArray &data, int tag = -1, bool preempt = false);
+    void enqueuePackages(const QList<QByteArray> &packages, int tag = -1, bool preempt = false);
+    void clear();
+
+    // Statistics
+    int queueDepth() const;
+    int pendingMessages() const;
+    quint64 bytesSent() const;
+    quint64 packagesSent() const;
+    quint64 cancelledMessages() const;
+    double throughput() const;
+
+signals:
+    void queueDepthChanged(int queueDepth);
+    void messageSent(int tag);
+
+private slots:
+    void onPacingTimeout();
+
+private:
+    struct Message {
+        QList<QByteArray> packages;
+        int index = 0;
+        int tag = -1;
+    };
+
+    QLowEnergyService *m_service = nullptr;
+    QBluetoothUuid m_characteristicUuid;
+    QTimer *m_pacingTimer = nullptr;
+
+    QList<Message> m_messages;
+    int m_packageSize = 20;
+    int m_windowSize = 4;
+    int m_credits = 4;
+
+    quint64 m_bytesSent = 0;
+    quint64 m_packagesSent = 0;
+    quint64 m_cancelledMessages = 0;
+    qint64 m_transmissionTime = 0;
+    QElapsedTimer m_transmissionTimer;
+
+    void cancelMessages(int tag);
+    void sendPackages();
+};
+
+#endif // TRANSMITQUEUE_H
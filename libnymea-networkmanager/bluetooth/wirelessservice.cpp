@@ -29,10 +29,34 @@
 
 */
 
+/*! \enum WirelessService::WirelessServiceCapability
+
+    Optional protocol features a client can request using the \c SetCapabilities (0x07) command. The response
+    to this command contains the accepted capabilities and is still encoded the old way. Requests written after
+    the \c SetCapabilities request, even back to back, have to be encoded using the accepted capabilities.
+
+    \value WirelessServiceCapabilityNone
+        JSON encoded data, terminated by a new line character.
+    \value WirelessServiceCapabilityCbor
+        CBOR encoded data. Mac addresses are encoded as 6 byte binary. Requires Qt 5.12.
+    \value WirelessServiceCapabilityCompression
+        Responses are sent as frames: 1 byte frame type, 4 byte big endian payload length and the payload.
+        Frame type 0x00 contains the encoded data as is, frame type 0x01 contains the encoded data compressed
+        using qCompress(), i.e. 4 byte big endian uncompressed length followed by the zlib stream. Only responses
+        exceeding the compression threshold get compressed. Requests are not affected.
+*/
+
 #include "wirelessservice.h"
 #include "bluetoothuuids.h"
+#include "../networkmanagerreply.h"
+
+#include <algorithm>
 
 #include <QJsonDocument>
+#if QT_VERSION >= QT_VERSION_CHECK(5,12,0)
+#include <QCborValue>
+#include <QCborStreamReader>
+#endif
 #include <QNetworkInterface>
 #include <QLowEnergyDescriptorData>
 #include <QLowEnergyCharacteristicData>
@@ -56,6 +80,21 @@ WirelessService::WirelessService(QLowEnergyService *service, NetworkManager *net
             (&QLowEnergyService::error), this, &WirelessService::serviceError);
 #endif
 
+    // Note: the buffer gets reused for all incoming commands
+    m_inputDataStream.reserve(1024);
+
+    // Responses get paced in order to not overrun the bluetooth controller
+    m_transmitQueue = new TransmitQueue(m_service, wirelessResponseCharacteristicUuid, this);
+    m_transmitQueue->setPackageSize(maximumPayloadSize());
+
+    // Network events get coalesced and sent at most once per interval
+    m_networkEventsQueue = new TransmitQueue(m_service, wirelessNetworkEventsCharacteristicUuid, this);
+    m_networkEventsQueue->setPackageSize(maximumPayloadSize());
+    m_networkEventsTimer = new QTimer(this);
+    m_networkEventsTimer->setInterval(1000);
+    m_networkEventsTimer->setSingleShot(true);
+    connect(m_networkEventsTimer, &QTimer::timeout, this, &WirelessService::sendNetworkEvents);
+
     // Get the wireless network device if there is any
     if (!m_networkManager->wirelessAvailable()) {
         qCWarning(dcNetworkManagerBluetoothServer()) << "WirelessService: There is no wireless network device available";
@@ -64,9 +103,9 @@ WirelessService::WirelessService(QLowEnergyService *service, NetworkManager *net
 
     qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Using" << m_networkManager->wirelessNetworkDevices().first();
     m_device = m_networkManager->wirelessNetworkDevices().first();
-    connect(m_device, &WirelessNetworkDevice::bitRateChanged, this, &WirelessService::onWirelessDeviceBitRateChanged);
     connect(m_device, &WirelessNetworkDevice::stateChanged, this, &WirelessService::onWirelessDeviceStateChanged);
     connect(m_device, &WirelessNetworkDevice::wirelessModeChanged, this, &WirelessService::onWirelessModeChanged);
+    connect(m_device, &WirelessNetworkDevice::accessPointGenerationChanged, this, &WirelessService::onAccessPointGenerationChanged);
 }
 
 QLowEnergyService *WirelessService::service()
@@ -74,6 +113,47 @@ QLowEnergyService *WirelessService::service()
     return m_service;
 }
 
+/*! Returns the \l{TransmitQueue} used for sending responses. */
+TransmitQueue *WirelessService::transmitQueue() const
+{
+    return m_transmitQueue;
+}
+
+/*! Returns the capabilities negotiated with the connected client. */
+WirelessService::WirelessServiceCapabilities WirelessService::capabilities() const
+{
+    return m_capabilities;
+}
+
+/*! Returns the capabilities this \l{WirelessService} is able to provide to a client. */
+WirelessService::WirelessServiceCapabilities WirelessService::supportedCapabilities()
+{
+    WirelessServiceCapabilities capabilities = WirelessServiceCapabilityCompression;
+#if QT_VERSION >= QT_VERSION_CHECK(5,12,0)
+    capabilities |= WirelessServiceCapabilityCbor;
+#endif
+    return capabilities;
+}
+
+/*! Returns the ATT MTU negotiated with the connected client. */
+int WirelessService::mtu() const
+{
+    return m_mtu;
+}
+
+/*! Sets the ATT MTU negotiated with the connected client to \a mtu. Responses will be sent in packages of up to \a mtu - 3 bytes. */
+void WirelessService::setMtu(int mtu)
+{
+    if (m_mtu == mtu)
+        return;
+
+    m_mtu = qMax(23, mtu);
+    m_transmitQueue->setPackageSize(maximumPayloadSize());
+    m_networkEventsQueue->setPackageSize(maximumPayloadSize());
+    m_networksCache.packages.clear();
+    qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Using ATT MTU" << m_mtu << "(" << maximumPayloadSize() << "bytes payload )";
+}
+
 QLowEnergyServiceData WirelessService::serviceData(NetworkManager *networkManager)
 {
     QLowEnergyServiceData serviceData;
@@ -95,7 +175,8 @@ QLowEnergyServiceData WirelessService::serviceData(NetworkManager *networkManage
     QLowEnergyCharacteristicData wirelessCommanderCharacteristicData;
     wirelessCommanderCharacteristicData.setUuid(wirelessCommanderCharacteristicUuid);
     wirelessCommanderCharacteristicData.setProperties(QLowEnergyCharacteristic::Write);
-    wirelessCommanderCharacteristicData.setValueLength(0, 20);
+    // Note: the actual package size depends on the negotiated MTU, 512 is the maximum attribute value length
+    wirelessCommanderCharacteristicData.setValueLength(0, 512);
     serviceData.addCharacteristic(wirelessCommanderCharacteristicData);
 
     // Response characterisitc e081fec2-f757-4449-b9c9-bfa83133f7fc
@@ -105,7 +186,7 @@ QLowEnergyServiceData WirelessService::serviceData(NetworkManager *networkManage
 #if QT_VERSION < QT_VERSION_CHECK(6,0,0)
     wirelessResponseCharacteristicData.addDescriptor(clientConfigDescriptorData);
 #endif
-    wirelessResponseCharacteristicData.setValueLength(0, 20);
+    wirelessResponseCharacteristicData.setValueLength(0, 512);
     serviceData.addCharacteristic(wirelessResponseCharacteristicData);
 
     // Wireless connection status characterisitc e081fec3-f757-4449-b9c9-bfa83133f7fc
@@ -138,6 +219,16 @@ QLowEnergyServiceData WirelessService::serviceData(NetworkManager *networkManage
     }
     serviceData.addCharacteristic(wirelessModeCharacteristicData);
 
+    // Network events characterisitc e081fec6-f757-4449-b9c9-bfa83133f7fc
+    QLowEnergyCharacteristicData networkEventsCharacteristicData;
+    networkEventsCharacteristicData.setUuid(wirelessNetworkEventsCharacteristicUuid);
+    networkEventsCharacteristicData.setProperties(QLowEnergyCharacteristic::Notify);
+#if QT_VERSION < QT_VERSION_CHECK(6,0,0)
+    networkEventsCharacteristicData.addDescriptor(clientConfigDescriptorData);
+#endif
+    networkEventsCharacteristicData.setValueLength(0, 512);
+    serviceData.addCharacteristic(networkEventsCharacteristicData);
+
     return serviceData;
 }
 
@@ -223,23 +314,131 @@ QByteArray WirelessService::getWirelessMode(WirelessNetworkDevice::WirelessMode
 
 void WirelessService::streamData(const QVariantMap &responseMap)
 {
-    QLowEnergyCharacteristic characteristic = m_service->characteristic(wirelessResponseCharacteristicUuid);
-    if (!characteristic.isValid()) {
-        qCWarning(dcNetworkManagerBluetoothServer()) << "WirelessService: Wireless response characteristic not valid";
-        return;
+    QByteArray data = serializeData(responseMap);
+    qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Queue response data:" << data.length() << "bytes";
+
+    // Note: a newer response to the same command replaces a stale one which has not been sent yet,
+    // unless the client is able to tell them apart using the request id
+    m_transmitQueue->enqueue(data, responseMap.contains("i") ? -1 : responseMap.value("c").toInt());
+
+    qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Queued packages:" << m_transmitQueue->queueDepth()
+                                                << "Throughput:" << m_transmitQueue->throughput() << "B/s";
+}
+
+QByteArray WirelessService::serializeData(const QVariantMap &dataMap) const
+{
+    QByteArray data = encodeData(dataMap);
+    if (m_capabilities.testFlag(WirelessServiceCapabilityCompression))
+        data = createFrame(data);
+
+    return data;
+}
+
+QByteArray WirelessService::serializeData(const QVariantMap &dataMap, const QString &key, const QByteArray &encodedValue) const
+{
+    QByteArray data = encodeData(dataMap, key, encodedValue);
+    if (m_capabilities.testFlag(WirelessServiceCapabilityCompression))
+        data = createFrame(data);
+
+    return data;
+}
+
+QByteArray WirelessService::encodeData(const QVariantMap &dataMap, const QString &key, const QByteArray &encodedValue) const
+{
+    // Note: the value has been encoded using encodeValue() before, only the remaining map gets encoded here
+    QByteArray data = encodeData(dataMap);
+#if QT_VERSION >= QT_VERSION_CHECK(5,12,0)
+    if (m_capabilities.testFlag(WirelessServiceCapabilityCbor)) {
+        // Note: maps with less than 24 pairs store the number of pairs in the initial byte
+        Q_ASSERT(dataMap.count() < 23);
+        data[0] = static_cast<char>(data.at(0) + 1);
+        data.append(QCborValue(key).toCbor());
+        data.append(encodedValue);
+        return data;
     }
+#endif
+
+    // Replace the closing brace and the terminator
+    data.chop(2);
+    if (!dataMap.isEmpty())
+        data.append(',');
+
+    data.append('"' + key.toUtf8() + "\":");
+    data.append(encodedValue);
+    data.append("}\n");
+    return data;
+}
+
+QByteArray WirelessService::encodeValue(const QVariant &value) const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,12,0)
+    if (m_capabilities.testFlag(WirelessServiceCapabilityCbor))
+        return QCborValue::fromVariant(value).toCbor();
+#endif
+
+    // Note: used for lists, the document does not contain a terminator in compact format
+    return QJsonDocument::fromVariant(value).toJson(QJsonDocument::Compact);
+}
+
+QByteArray WirelessService::encodeData(const QVariantMap &dataMap) const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,12,0)
+    // Note: CBOR is self-delimiting, no terminator required
+    if (m_capabilities.testFlag(WirelessServiceCapabilityCbor))
+        return QCborValue::fromVariant(dataMap).toCbor();
+#endif
 
-    QByteArray data = QJsonDocument::fromVariant(responseMap).toJson(QJsonDocument::Compact) + '\n';
-    qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Start streaming response data:" << data.length() << "bytes";
+    return QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Compact) + '\n';
+}
 
-    QByteArray remainingData = data;
-    while (!remainingData.isEmpty()) {
-        QByteArray package = remainingData.left(20);
-        m_service->writeCharacteristic(characteristic, package);
-        remainingData = remainingData.remove(0, package.length());
+QByteArray WirelessService::createFrame(const QByteArray &data) const
+{
+    quint8 frameType = 0x00;
+    QByteArray payload = data;
+    if (data.length() >= m_compressionThreshold) {
+        QByteArray compressedData = qCompress(data, 9);
+        if (compressedData.length() < data.length()) {
+            qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Compressed response data from" << data.length() << "to" << compressedData.length() << "bytes";
+            frameType = 0x01;
+            payload = compressedData;
+        }
     }
 
-    qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Finished streaming response data";
+    QByteArray frame;
+    frame.reserve(payload.length() + 5);
+    frame.append(static_cast<char>(frameType));
+    const quint32 length = static_cast<quint32>(payload.length());
+    frame.append(static_cast<char>((length >> 24) & 0xff));
+    frame.append(static_cast<char>((length >> 16) & 0xff));
+    frame.append(static_cast<char>((length >> 8) & 0xff));
+    frame.append(static_cast<char>(length & 0xff));
+    frame.append(payload);
+    return frame;
+}
+
+QVariant WirelessService::encodeMacAddress(const QString &macAddress) const
+{
+    // Note: in CBOR mode the mac address gets encoded as 6 byte binary instead of the 17 characters string
+    if (m_capabilities.testFlag(WirelessServiceCapabilityCbor))
+        return QByteArray::fromHex(macAddress.toLatin1());
+
+    return macAddress;
+}
+
+QVariantMap WirelessService::accessPointVariantMap(WirelessAccessPoint *accessPoint) const
+{
+    QVariantMap accessPointVariantMap;
+    accessPointVariantMap.insert("e", accessPoint->ssid());
+    accessPointVariantMap.insert("m", encodeMacAddress(accessPoint->macAddress()));
+    accessPointVariantMap.insert("s", accessPoint->signalStrength());
+    accessPointVariantMap.insert("p", static_cast<int>(accessPoint->isProtected()));
+    return accessPointVariantMap;
+}
+
+int WirelessService::maximumPayloadSize() const
+{
+    // ATT notification and write request header: 1 byte opcode, 2 bytes handle
+    return qBound(20, m_mtu - 3, 512);
 }
 
 QVariantMap WirelessService::createResponse(const WirelessService::WirelessServiceCommand &command, const WirelessService::WirelessServiceResponse &responseCode)
@@ -247,13 +446,14 @@ QVariantMap WirelessService::createResponse(const WirelessService::WirelessServi
     QVariantMap response;
     response.insert("c", static_cast<int>(command));
     response.insert("r", static_cast<int>(responseCode));
+    if (m_requestId.isValid())
+        response.insert("i", m_requestId);
+
     return response;
 }
 
 void WirelessService::commandGetNetworks(const QVariantMap &request)
 {
-    Q_UNUSED(request)
-
     if (!m_service) {
         qCWarning(dcNetworkManagerBluetoothServer()) << "WirelessService: Could not stream wireless network list. Service not valid";
         return;
@@ -265,20 +465,127 @@ void WirelessService::commandGetNetworks(const QVariantMap &request)
         return;
     }
 
-    QVariantList accessPointVariantList;
-    foreach (WirelessAccessPoint *accessPoint, m_device->accessPoints()) {
-        QVariantMap accessPointVariantMap;
-        accessPointVariantMap.insert("e", accessPoint->ssid());
-        accessPointVariantMap.insert("m", accessPoint->macAddress());
-        accessPointVariantMap.insert("s", accessPoint->signalStrength());
-        accessPointVariantMap.insert("p", static_cast<int>(accessPoint->isProtected()));
-        accessPointVariantList.append(accessPointVariantMap);
+    // Note: all parameters are optional, without parameters all networks get returned
+    QVariantMap parameters = request.value("p").toMap();
+    int minimumStrength = parameters.value("s", 0).toInt();
+    int count = parameters.value("n", -1).toInt();
+    int offset = qMax(0, parameters.value("o", 0).toInt());
+    bool includeHidden = parameters.value("h", true).toBool();
+    bool unique = parameters.value("u", false).toBool();
+    WirelessServiceSortOrder sortOrder = static_cast<WirelessServiceSortOrder>(parameters.value("x", WirelessServiceSortOrderNone).toInt());
+
+    // Note: the cached network list depends on the parameters and on how the data gets encoded
+    QString cacheKey = QString("%1:%2:%3:%4:%5:%6:%7").arg(minimumStrength).arg(count).arg(offset)
+            .arg(static_cast<int>(includeHidden)).arg(static_cast<int>(unique)).arg(static_cast<int>(sortOrder))
+            .arg(static_cast<int>(m_capabilities));
+
+    if (networksCacheValid(cacheKey)) {
+        qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Reuse cached network list:" << m_networksCache.networks.length() << "bytes";
+    } else {
+        buildNetworksCache(cacheKey, minimumStrength, count, offset, includeHidden, unique, sortOrder);
     }
 
     QVariantMap response = createResponse(WirelessServiceCommandGetNetworks);
-    response.insert("p", accessPointVariantList);
 
-    streamData(response);
+    // Let paginating clients know how many networks are available in total
+    if (count >= 0 || offset > 0)
+        response.insert("t", m_networksCache.total);
+
+    // Note: responses with a request id are unique, only the encoded network list can be reused for them
+    if (m_requestId.isValid()) {
+        QByteArray data = serializeData(response, "p", m_networksCache.networks);
+        qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Queue network list:" << data.length() << "bytes";
+        m_transmitQueue->enqueue(data);
+        return;
+    }
+
+    if (m_networksCache.packages.isEmpty())
+        m_networksCache.packages = m_transmitQueue->createPackages(serializeData(response, "p", m_networksCache.networks));
+
+    qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Queue network list:" << m_networksCache.packages.count() << "packages";
+    m_transmitQueue->enqueuePackages(m_networksCache.packages, WirelessServiceCommandGetNetworks);
+}
+
+void WirelessService::buildNetworksCache(const QString &key, int minimumStrength, int count, int offset, bool includeHidden, bool unique, WirelessServiceSortOrder sortOrder)
+{
+    QList<WirelessAccessPoint *> accessPoints;
+    QHash<QString, int> uniqueIndexes;
+    QHash<QString, int> signalStrengths;
+    foreach (WirelessAccessPoint *accessPoint, m_device->accessPoints()) {
+        signalStrengths.insert(accessPoint->macAddress(), accessPoint->signalStrength());
+        if (accessPoint->signalStrength() < minimumStrength)
+            continue;
+
+        if (!includeHidden && accessPoint->ssid().isEmpty())
+            continue;
+
+        // Keep the strongest BSSID for each SSID
+        if (unique && !accessPoint->ssid().isEmpty()) {
+            if (uniqueIndexes.contains(accessPoint->ssid())) {
+                int index = uniqueIndexes.value(accessPoint->ssid());
+                if (accessPoint->signalStrength() > accessPoints.at(index)->signalStrength())
+                    accessPoints[index] = accessPoint;
+
+                continue;
+            }
+            uniqueIndexes.insert(accessPoint->ssid(), accessPoints.count());
+        }
+
+        accessPoints.append(accessPoint);
+    }
+
+    switch (sortOrder) {
+    case WirelessServiceSortOrderSignalStrength:
+        std::sort(accessPoints.begin(), accessPoints.end(), [](WirelessAccessPoint *a, WirelessAccessPoint *b) {
+            return a->signalStrength() > b->signalStrength();
+        });
+        break;
+    case WirelessServiceSortOrderSsid:
+        std::sort(accessPoints.begin(), accessPoints.end(), [](WirelessAccessPoint *a, WirelessAccessPoint *b) {
+            return a->ssid().compare(b->ssid(), Qt::CaseInsensitive) < 0;
+        });
+        break;
+    default:
+        break;
+    }
+
+    QVariantList accessPointVariantList;
+    for (int i = offset; i < accessPoints.count(); i++) {
+        if (count >= 0 && accessPointVariantList.count() >= count)
+            break;
+
+        accessPointVariantList.append(accessPointVariantMap(accessPoints.at(i)));
+    }
+
+    m_networksCache.key = key;
+    m_networksCache.generation = m_device->accessPointGeneration();
+    m_networksCache.signalStrengths = signalStrengths;
+    m_networksCache.networks = encodeValue(accessPointVariantList);
+    m_networksCache.total = accessPoints.count();
+    m_networksCache.packages.clear();
+}
+
+bool WirelessService::networksCacheValid(const QString &key)
+{
+    if (m_networksCache.key.isEmpty() || m_networksCache.key != key)
+        return false;
+
+    if (m_networksCache.generation == m_device->accessPointGeneration())
+        return true;
+
+    // Any added or removed access point invalidates the cache
+    if (!m_device->accessPointChangesAvailable(m_networksCache.generation) || !m_device->accessPointsRemovedSince(m_networksCache.generation).isEmpty())
+        return false;
+
+    // Small signal strength changes are not worth rebuilding the list. Note: compare with the cached values, so changes can not add up unnoticed
+    foreach (WirelessAccessPoint *accessPoint, m_device->accessPointsChangedSince(m_networksCache.generation)) {
+        QHash<QString, int>::const_iterator it = m_networksCache.signalStrengths.constFind(accessPoint->macAddress());
+        if (it == m_networksCache.signalStrengths.constEnd() || qAbs(it.value() - accessPoint->signalStrength()) >= m_networksCacheThreshold)
+            return false;
+    }
+
+    m_networksCache.generation = m_device->accessPointGeneration();
+    return true;
 }
 
 void WirelessService::commandConnect(const QVariantMap &request)
@@ -333,22 +640,29 @@ void WirelessService::commandConnect(const QVariantMap &request)
 
     bool hidden = parameters.contains("h") && parameters.value("h").toBool();
 
-    NetworkManager::NetworkManagerError networkError = m_networkManager->connectWifi(m_device->interface(), parameters.value("e").toString(), parameters.value("p").toString(), authAlgorithm, keyMgmt, hidden);
-    WirelessService::WirelessServiceResponse responseCode = WirelessService::WirelessServiceResponseSuccess;
-    switch (networkError) {
-    case NetworkManager::NetworkManagerErrorNoError:
-        break;
-    case NetworkManager::NetworkManagerErrorWirelessNetworkingDisabled:
-        responseCode = WirelessService::WirelessServiceResponseWirelessNotEnabled;
-        break;
-    case NetworkManager::NetworkManagerErrorWirelessConnectionFailed:
-        responseCode = WirelessService::WirelessServiceResponseUnknownError;
-        break;
-    default:
-        responseCode = WirelessService::WirelessServiceResponseUnknownError;
-        break;
-    }
-    streamData(createResponse(WirelessServiceCommandConnect, responseCode));
+    // Note: the activation takes a while, following requests get processed meanwhile and the response carries the request id
+    NetworkManagerReply *reply = m_networkManager->connectWifiAsync(m_device->interface(), parameters.value("e").toString(), parameters.value("p").toString(), authAlgorithm, keyMgmt, hidden);
+    QVariant requestId = m_requestId;
+    connect(reply, &NetworkManagerReply::finished, this, [this, reply, requestId](){
+        WirelessService::WirelessServiceResponse responseCode = WirelessService::WirelessServiceResponseSuccess;
+        switch (reply->error()) {
+        case NetworkManager::NetworkManagerErrorNoError:
+            break;
+        case NetworkManager::NetworkManagerErrorWirelessNetworkingDisabled:
+            responseCode = WirelessService::WirelessServiceResponseWirelessNotEnabled;
+            break;
+        case NetworkManager::NetworkManagerErrorWirelessConnectionFailed:
+            responseCode = WirelessService::WirelessServiceResponseUnknownError;
+            break;
+        default:
+            responseCode = WirelessService::WirelessServiceResponseUnknownError;
+            break;
+        }
+
+        m_requestId = requestId;
+        streamData(createResponse(WirelessServiceCommandConnect, responseCode));
+        m_requestId.clear();
+    });
 }
 
 void WirelessService::commandDisconnect(const QVariantMap &request)
@@ -385,7 +699,7 @@ void WirelessService::commandScan(const QVariantMap &request)
         return;
     }
 
-    m_device->scanWirelessNetworks();
+    m_device->requestScan();
     streamData(createResponse(WirelessServiceCommandScan));
 }
 
@@ -409,7 +723,7 @@ void WirelessService::commandGetCurrentConnection(const QVariantMap &request)
     if (!m_device->activeAccessPoint() || !wifiInterface.isValid() || wifiInterface.addressEntries().isEmpty()) {
         qCDebug(dcNetworkManagerBluetoothServer()) << "There is currently no access active accesspoint";
         connectionDataMap.insert("e", "");
-        connectionDataMap.insert("m", "");
+        connectionDataMap.insert("m", encodeMacAddress(QString()));
         connectionDataMap.insert("s", 0);
         connectionDataMap.insert("p", 0);
         connectionDataMap.insert("i", "");
@@ -425,7 +739,7 @@ void WirelessService::commandGetCurrentConnection(const QVariantMap &request)
         }
         qCDebug(dcNetworkManagerBluetoothServer()) << "Current connection:" << m_device->activeAccessPoint() << address.toString();
         connectionDataMap.insert("e", m_device->activeAccessPoint()->ssid());
-        connectionDataMap.insert("m", m_device->activeAccessPoint()->macAddress());
+        connectionDataMap.insert("m", encodeMacAddress(m_device->activeAccessPoint()->macAddress()));
         connectionDataMap.insert("s", m_device->activeAccessPoint()->signalStrength());
         connectionDataMap.insert("p", static_cast<int>(m_device->activeAccessPoint()->isProtected()));
         connectionDataMap.insert("i", address.toString());
@@ -482,56 +796,224 @@ void WirelessService::commandStartAccessPoint(const QVariantMap &request)
         return;
     }
 
-    NetworkManager::NetworkManagerError status = m_networkManager->startAccessPoint(m_device->interface(), essid, passkey);
-    if (status != NetworkManager::NetworkManagerErrorNoError) {
-        qCWarning(dcNetworkManagerBluetoothServer()) << "Failed to start the access point:" << status;
-        // FIXME: Add more error codes so that we can actually report this failure to the client
-        streamData(createResponse(WirelessServiceCommandStartAccessPoint, WirelessServiceResponseUnknownError));
+    NetworkManagerReply *reply = m_networkManager->startAccessPointAsync(m_device->interface(), essid, passkey);
+    QVariant requestId = m_requestId;
+    connect(reply, &NetworkManagerReply::finished, this, [this, reply, requestId](){
+        m_requestId = requestId;
+        if (reply->error() != NetworkManager::NetworkManagerErrorNoError) {
+            qCWarning(dcNetworkManagerBluetoothServer()) << "Failed to start the access point:" << reply->error();
+            // FIXME: Add more error codes so that we can actually report this failure to the client
+            streamData(createResponse(WirelessServiceCommandStartAccessPoint, WirelessServiceResponseUnknownError));
+        } else {
+            streamData(createResponse(WirelessServiceCommandStartAccessPoint, WirelessServiceResponseSuccess));
+        }
+        m_requestId.clear();
+    });
+}
+
+void WirelessService::commandSetCapabilities(const QVariantMap &request)
+{
+    if (!request.contains("p")) {
+        qCWarning(dcNetworkManagerBluetoothServer()) << "WirelessService: Set capabilities command: Missing parameters.";
+        streamData(createResponse(WirelessServiceCommandSetCapabilities, WirelessServiceResponseIvalidParameters));
+        return;
+    }
+
+    bool flagsIntOk;
+    int flags = request.value("p").toMap().value("f").toInt(&flagsIntOk);
+    if (!flagsIntOk) {
+        qCWarning(dcNetworkManagerBluetoothServer()) << "WirelessService: Set capabilities command: Invalid capabilities (f) parameter.";
+        streamData(createResponse(WirelessServiceCommandSetCapabilities, WirelessServiceResponseIvalidParameters));
         return;
     }
 
-    streamData(createResponse(WirelessServiceCommandStartAccessPoint, WirelessServiceResponseSuccess));
+    WirelessServiceCapabilities capabilities = WirelessServiceCapabilities(flags) & supportedCapabilities();
+
+    // Note: the response is still encoded using the previous capabilities, the new ones apply to all following data
+    QVariantMap parameters;
+    parameters.insert("f", static_cast<int>(capabilities));
+    QVariantMap response = createResponse(WirelessServiceCommandSetCapabilities);
+    response.insert("p", parameters);
+    streamData(response);
+
+    // Note: the input encoding has already been switched once the request has been parsed
+    qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Using capabilities" << capabilities;
+    m_capabilities = capabilities;
 }
 
 void WirelessService::characteristicChanged(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
 {
     // Command
     if (characteristic.uuid() == wirelessCommanderCharacteristicUuid) {
-        // Check if currently reading
-        if (m_readingInputData) {
-            m_inputDataStream.append(value);
+        // Note: the ATT layer limits single writes to the MTU already, long (prepared) writes may use the whole characteristic value.
+        // Oversized commands get caught by the limit of the command stream.
+        if (value.length() > 512) {
+            qCWarning(dcNetworkManagerBluetoothServer()) << "WirelessService: Package exceeds the maximum characteristic value length. Dropping command stream.";
+            m_inputDataStream.resize(0);
+            m_discardingInputData = true;
+            return;
+        }
+
+        processInputData(value);
+    }
+}
+
+void WirelessService::commandGetNetworkChanges(const QVariantMap &request)
+{
+    // Note: generation 0 or a missing parameter requests the full list
+    QVariantMap response = createResponse(WirelessServiceCommandGetNetworkChanges);
+    response.insert("p", networkChanges(request.value("p").toMap().value("g").toUInt()));
+    streamData(response);
+}
+
+QVariantMap WirelessService::networkChanges(quint32 generation) const
+{
+    bool full = !m_device->accessPointChangesAvailable(generation);
+
+    QVariantList changedVariantList;
+    QVariantList removedVariantList;
+    if (full) {
+        foreach (WirelessAccessPoint *accessPoint, m_device->accessPoints()) {
+            changedVariantList.append(accessPointVariantMap(accessPoint));
+        }
+    } else {
+        foreach (WirelessAccessPoint *accessPoint, m_device->accessPointsChangedSince(generation)) {
+            changedVariantList.append(accessPointVariantMap(accessPoint));
+        }
+        foreach (const QString &bssid, m_device->accessPointsRemovedSince(generation)) {
+            removedVariantList.append(encodeMacAddress(bssid));
+        }
+    }
+
+    qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Network changes since generation" << generation << (full ? "(full list)" : "")
+                                                << "changed:" << changedVariantList.count() << "removed:" << removedVariantList.count();
+
+    QVariantMap parameters;
+    parameters.insert("g", m_device->accessPointGeneration());
+    parameters.insert("f", static_cast<int>(full));
+    parameters.insert("a", changedVariantList);
+    parameters.insert("d", removedVariantList);
+    return parameters;
+}
+
+void WirelessService::processInputData(const QByteArray &data)
+{
+    if (m_discardingInputData && m_inputCapabilities.testFlag(WirelessServiceCapabilityCbor)) {
+        // Note: CBOR has no delimiter, resynchronize on the first write starting with a map, i.e. a new request
+        if (data.isEmpty() || (static_cast<quint8>(data.at(0)) & 0xe0) != 0xa0)
+            return;
+
+        m_discardingInputData = false;
+    }
+
+    // Note: only the new data has to be scanned for delimiters, the buffer contains no complete frame
+    int scanOffset = m_inputDataStream.length();
+    m_inputDataStream.append(data);
+
+    // The remaining data has to be parsed again if a request switched the encoding
+    bool encodingChanged = true;
+    while (encodingChanged) {
+        if (m_inputCapabilities.testFlag(WirelessServiceCapabilityCbor)) {
+            encodingChanged = processCborInputData();
         } else {
-            m_inputDataStream.clear();
-            m_readingInputData = true;
-            m_inputDataStream.append(value);
+            encodingChanged = processJsonInputData(scanOffset);
         }
+        scanOffset = 0;
+    }
+
+    // Limit the size of a single request to prevent overflow, drop everything until the stream can be resynchronized
+    if (m_inputDataStream.length() >= 20 * 1024) {
+        qCWarning(dcNetworkManagerBluetoothServer()) << "WirelessService: Command exceeds the maximum size. Dropping command stream.";
+        m_discardingInputData = true;
+    }
+
+    // Note: while discarding, nothing has to be kept. The reserved capacity stays allocated.
+    if (m_discardingInputData)
+        m_inputDataStream.resize(0);
+}
 
-        // If command finished
-        if (value.endsWith('\n')) {
+bool WirelessService::updateInputCapabilities(const QVariantMap &request)
+{
+    if (request.value("c").toInt() != WirelessServiceCommandSetCapabilities)
+        return false;
+
+    // Note: invalid parameters get rejected by the command, the encoding stays the same
+    bool flagsIntOk;
+    int flags = request.value("p").toMap().value("f").toInt(&flagsIntOk);
+    if (!flagsIntOk)
+        return false;
+
+    WirelessServiceCapabilities capabilities = WirelessServiceCapabilities(flags) & supportedCapabilities();
+    bool encodingChanged = capabilities.testFlag(WirelessServiceCapabilityCbor) != m_inputCapabilities.testFlag(WirelessServiceCapabilityCbor);
+    m_inputCapabilities = capabilities;
+    return encodingChanged;
+}
+
+bool WirelessService::processJsonInputData(int scanOffset)
+{
+    int frameStart = 0;
+    int index = m_inputDataStream.indexOf('\n', scanOffset);
+
+    // Dispatch every complete frame, several commands might have been written back to back
+    while (index >= 0) {
+        if (m_discardingInputData) {
+            // Resynchronize after dropped data
+            m_discardingInputData = false;
+        } else if (index > frameStart) {
             QJsonParseError error;
-            QJsonDocument jsonDocument = QJsonDocument::fromJson(m_inputDataStream, &error);
+            QJsonDocument jsonDocument = QJsonDocument::fromJson(QByteArray::fromRawData(m_inputDataStream.constData() + frameStart, index - frameStart), &error);
             if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcNetworkManagerBluetoothServer()) << "Got invalid json object" << m_inputDataStream;
-                m_inputDataStream.clear();
-                m_readingInputData = false;
-                return;
+                qCWarning(dcNetworkManagerBluetoothServer()) << "Got invalid json object" << m_inputDataStream.mid(frameStart, index - frameStart);
+            } else {
+                qCDebug(dcNetworkManagerBluetoothServer()) << "Got command stream" << jsonDocument.toJson();
+                QVariantMap request = jsonDocument.toVariant().toMap();
+
+                // Note: the following frames are encoded differently, the caller parses them again. A rejected request changes nothing.
+                if (queueRequest(request) && updateInputCapabilities(request)) {
+                    m_inputDataStream.remove(0, index + 1);
+                    return true;
+                }
             }
+        }
 
-            qCDebug(dcNetworkManagerBluetoothServer()) << "Got command stream" << jsonDocument.toJson();
+        frameStart = index + 1;
+        index = m_inputDataStream.indexOf('\n', frameStart);
+    }
 
-            processCommand(jsonDocument.toVariant().toMap());
+    // Keep only the incomplete frame, the reserved capacity stays allocated
+    m_inputDataStream.remove(0, frameStart);
+    return false;
+}
 
-            m_inputDataStream.clear();
-            m_readingInputData = false;
+bool WirelessService::processCborInputData()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,12,0)
+    // Note: CBOR values are self-delimiting, process every complete value in the stream
+    while (!m_inputDataStream.isEmpty()) {
+        QCborStreamReader reader(m_inputDataStream);
+        QCborValue value = QCborValue::fromCbor(reader);
+        if (reader.lastError() == QCborError::EndOfFile) {
+            // Wait for more data
+            return false;
         }
 
-        // Limit possible data stream to prevent overflow
-        if (m_inputDataStream.length() >= 20 * 1024) {
-            m_inputDataStream.clear();
-            m_readingInputData = false;
-            return;
+        if (reader.lastError() != QCborError::NoError || !value.isMap()) {
+            qCWarning(dcNetworkManagerBluetoothServer()) << "Got invalid CBOR data" << m_inputDataStream.toHex() << reader.lastError().toString();
+            m_discardingInputData = true;
+            return false;
         }
+
+        m_inputDataStream.remove(0, static_cast<int>(reader.currentOffset()));
+
+        qCDebug(dcNetworkManagerBluetoothServer()) << "Got command stream" << value.toDiagnosticNotation();
+        QVariantMap request = value.toVariant().toMap();
+
+        // Note: the remaining data is encoded differently, the caller parses it again. A rejected request changes nothing.
+        if (queueRequest(request) && updateInputCapabilities(request))
+            return true;
     }
+#endif
+    return false;
 }
 
 void WirelessService::characteristicRead(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
@@ -552,6 +1034,29 @@ void WirelessService::descriptorRead(const QLowEnergyDescriptor &descriptor, con
 void WirelessService::descriptorWritten(const QLowEnergyDescriptor &descriptor, const QByteArray &value)
 {
     qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Descriptor written" << descriptor.uuid().toString() << value;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
+    QLowEnergyDescriptor networkEventsDescriptor = m_service->characteristic(wirelessNetworkEventsCharacteristicUuid).descriptor(QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration);
+#else
+    QLowEnergyDescriptor networkEventsDescriptor = m_service->characteristic(wirelessNetworkEventsCharacteristicUuid).descriptor(QBluetoothUuid::ClientCharacteristicConfiguration);
+#endif
+    if (!networkEventsDescriptor.isValid() || networkEventsDescriptor.handle() != descriptor.handle())
+        return;
+
+    // Note: the first byte enables notifications (0x01) or indications (0x02)
+    bool enabled = !value.isEmpty() && (value.at(0) & 0x03);
+    if (m_networkEventsEnabled == enabled)
+        return;
+
+    qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Network events" << (enabled ? "enabled" : "disabled");
+    m_networkEventsEnabled = enabled;
+    if (m_networkEventsEnabled && m_device) {
+        // Events start from the current state, the client fetches the initial list using GetNetworks or GetNetworkChanges
+        m_networkEventsGeneration = m_device->accessPointGeneration();
+    } else {
+        m_networkEventsTimer->stop();
+        m_networkEventsQueue->clear();
+    }
 }
 
 void WirelessService::serviceError(QLowEnergyService::ServiceError error)
@@ -584,6 +1089,40 @@ void WirelessService::serviceError(QLowEnergyService::ServiceError error)
     qCWarning(dcNetworkManagerBluetoothServer()) << "WirelessService: Error:" << errorString;
 }
 
+bool WirelessService::queueRequest(const QVariantMap &request)
+{
+    // Note: keep the queue small, the client has to wait for responses anyways
+    if (m_requestQueue.count() >= 8) {
+        qCWarning(dcNetworkManagerBluetoothServer()) << "WirelessService: Too many pending requests. Rejecting request" << request;
+        m_requestId = request.value("i");
+        streamData(createResponse(static_cast<WirelessServiceCommand>(request.value("c", WirelessServiceCommandInvalid).toInt()), WirelessServiceResponseUnknownError));
+        m_requestId.clear();
+        return false;
+    }
+
+    m_requestQueue.append(request);
+    if (m_requestQueue.count() == 1) {
+        QTimer::singleShot(0, this, &WirelessService::processRequestQueue);
+    }
+    return true;
+}
+
+void WirelessService::processRequestQueue()
+{
+    if (m_requestQueue.isEmpty())
+        return;
+
+    // Process one request per event loop iteration in order to not block the transmission of responses
+    QVariantMap request = m_requestQueue.takeFirst();
+    m_requestId = request.value("i");
+    processCommand(request);
+    m_requestId.clear();
+
+    if (!m_requestQueue.isEmpty()) {
+        QTimer::singleShot(0, this, &WirelessService::processRequestQueue);
+    }
+}
+
 void WirelessService::processCommand(const QVariantMap &request)
 {
     if (!request.contains("c")) {
@@ -600,6 +1139,12 @@ void WirelessService::processCommand(const QVariantMap &request)
         return;
     }
 
+    // Note: the capabilities can be negotiated even if the wireless device is not usable
+    if (command == WirelessServiceCommandSetCapabilities) {
+        commandSetCapabilities(request);
+        return;
+    }
+
     // Check wireless errors
     WirelessServiceResponse responseCode = checkWirelessErrors();
     if (responseCode != WirelessServiceResponseSuccess) {
@@ -628,6 +1173,9 @@ void WirelessService::processCommand(const QVariantMap &request)
     case WirelessServiceCommandStartAccessPoint:
         commandStartAccessPoint(request);
         break;
+    case WirelessServiceCommandGetNetworkChanges:
+        commandGetNetworkChanges(request);
+        break;
     default:
         qCWarning(dcNetworkManagerBluetoothServer()) << "Invalid request. Unknown command" << command;
         streamData(createResponse(WirelessServiceCommandConnect, WirelessServiceResponseIvalidCommand));
@@ -635,9 +1183,36 @@ void WirelessService::processCommand(const QVariantMap &request)
     }
 }
 
-void WirelessService::onWirelessDeviceBitRateChanged(const int &bitRate)
+void WirelessService::onAccessPointGenerationChanged()
 {
-    Q_UNUSED(bitRate)
+    if (!m_networkEventsEnabled || m_networkEventsTimer->isActive())
+        return;
+
+    m_networkEventsTimer->start();
+}
+
+void WirelessService::sendNetworkEvents()
+{
+    if (!m_networkEventsEnabled || !m_device)
+        return;
+
+    // Don't pile up events on a slow link, the next event will contain the changes of this one
+    if (m_networkEventsQueue->pendingMessages() > 0) {
+        m_networkEventsTimer->start();
+        return;
+    }
+
+    if (m_networkEventsGeneration == m_device->accessPointGeneration())
+        return;
+
+    QVariantMap event = networkChanges(m_networkEventsGeneration);
+    event.insert("b", m_networkEventsGeneration);
+    m_networkEventsGeneration = m_device->accessPointGeneration();
+
+    QByteArray data = serializeData(event);
+
+    qCDebug(dcNetworkManagerBluetoothServer()) << "WirelessService: Send network event:" << data.length() << "bytes";
+    m_networkEventsQueue->enqueue(data);
 }
 
 void WirelessService::onWirelessDeviceStateChanged(const NetworkDevice::NetworkDeviceState &state)
@@ -25,11 +25,13 @@
 #ifndef WIRELESSSERVICE_H
 #define WIRELESSSERVICE_H
 
+#include <QTimer>
 #include <QObject>
 #include <QVariantMap>
 #include <QLowEnergyService>
 #include <QLowEnergyServiceData>
 
+#include "transmitqueue.h"
 #include "../networkmanager.h"
 #include "../wirelessaccesspoint.h"
 #include "../wirelessnetworkdevice.h"
@@ -46,10 +48,28 @@ public:
         WirelessServiceCommandDisconnect            = 0x03,
         WirelessServiceCommandScan                  = 0x04,
         WirelessServiceCommandGetCurrentConnection  = 0x05,
-        WirelessServiceCommandStartAccessPoint      = 0x06
+        WirelessServiceCommandStartAccessPoint      = 0x06,
+        WirelessServiceCommandSetCapabilities       = 0x07,
+        WirelessServiceCommandGetNetworkChanges     = 0x08
     };
     Q_ENUM(WirelessServiceCommand)
 
+    enum WirelessServiceCapability {
+        WirelessServiceCapabilityNone = 0x00,
+        WirelessServiceCapabilityCbor = 0x01,
+        WirelessServiceCapabilityCompression = 0x02
+    };
+    Q_ENUM(WirelessServiceCapability)
+
+    enum WirelessServiceSortOrder {
+        WirelessServiceSortOrderNone            = 0x00,
+        WirelessServiceSortOrderSignalStrength  = 0x01,
+        WirelessServiceSortOrderSsid            = 0x02
+    };
+    Q_ENUM(WirelessServiceSortOrder)
+    Q_DECLARE_FLAGS(WirelessServiceCapabilities, WirelessServiceCapability)
+    Q_FLAG(WirelessServiceCapabilities)
+
     enum WirelessServiceResponse {
         WirelessServiceResponseSuccess                     = 0x00,
         WirelessServiceResponseIvalidCommand               = 0x01,
@@ -64,6 +84,13 @@ public:
 
     explicit WirelessService(QLowEnergyService *service, NetworkManager *networkManager, QObject *parent = nullptr);
     QLowEnergyService *service();
+    TransmitQueue *transmitQueue() const;
+
+    WirelessServiceCapabilities capabilities() const;
+    static WirelessServiceCapabilities supportedCapabilities();
+
+    int mtu() const;
+    void setMtu(int mtu);
 
     static QLowEnergyServiceData serviceData(NetworkManager *networkManager);
 
@@ -71,9 +98,47 @@ private:
     QLowEnergyService *m_service = nullptr;
     NetworkManager *m_networkManager = nullptr;
     WirelessNetworkDevice *m_device = nullptr;
+    TransmitQueue *m_transmitQueue = nullptr;
+
+    // Network events
+    TransmitQueue *m_networkEventsQueue = nullptr;
+    QTimer *m_networkEventsTimer = nullptr;
+    bool m_networkEventsEnabled = false;
+    quint32 m_networkEventsGeneration = 0;
+
+    // Encoded GetNetworks network list, reused as long as the networks did not change significantly.
+    // The response envelope gets added per request, only responses without request id are cached completely.
+    struct NetworksCache {
+        QString key;
+        quint32 generation = 0;
+        QHash<QString, int> signalStrengths;
+        QByteArray networks;
+        int total = 0;
+        QList<QByteArray> packages;
+    };
+    NetworksCache m_networksCache;
+    int m_networksCacheThreshold = 5;
+    bool networksCacheValid(const QString &key);
+    void buildNetworksCache(const QString &key, int minimumStrength, int count, int offset, bool includeHidden, bool unique, WirelessServiceSortOrder sortOrder);
 
-    bool m_readingInputData = false;
     QByteArray m_inputDataStream;
+    bool m_discardingInputData = false;
+
+    // Note: commands can be written back to back, the optional request id (i) gets echoed in the response
+    QList<QVariantMap> m_requestQueue;
+    QVariant m_requestId;
+    bool queueRequest(const QVariantMap &request);
+
+    WirelessServiceCapabilities m_capabilities = WirelessServiceCapabilityNone;
+    // Note: requests following SetCapabilities get decoded with the new capabilities before the command has been processed
+    WirelessServiceCapabilities m_inputCapabilities = WirelessServiceCapabilityNone;
+
+    // Note: smaller responses, like status codes, don't benefit from compression
+    int m_compressionThreshold = 256;
+
+    // Note: 23 is the default ATT MTU if the client does not negotiate a larger one
+    int m_mtu = 23;
+    int maximumPayloadSize() const;
 
     WirelessServiceResponse checkWirelessErrors();
 
@@ -82,6 +147,18 @@ private:
     static QByteArray getWirelessMode(WirelessNetworkDevice::WirelessMode mode);
 
     void streamData(const QVariantMap &responseMap);
+    QByteArray serializeData(const QVariantMap &dataMap) const;
+    QByteArray serializeData(const QVariantMap &dataMap, const QString &key, const QByteArray &encodedValue) const;
+    QByteArray encodeData(const QVariantMap &dataMap) const;
+    QByteArray encodeData(const QVariantMap &dataMap, const QString &key, const QByteArray &encodedValue) const;
+    QByteArray encodeValue(const QVariant &value) const;
+    QByteArray createFrame(const QByteArray &data) const;
+    QVariant encodeMacAddress(const QString &macAddress) const;
+    QVariantMap accessPointVariantMap(WirelessAccessPoint *accessPoint) const;
+    void processInputData(const QByteArray &data);
+    bool updateInputCapabilities(const QVariantMap &request);
+    bool processJsonInputData(int scanOffset);
+    bool processCborInputData();
 
     QVariantMap createResponse(const WirelessServiceCommand &command, const WirelessServiceResponse &responseCode = WirelessServiceResponseSuccess);
 
@@ -92,6 +169,9 @@ private:
     void commandScan(const QVariantMap &request);
     void commandGetCurrentConnection(const QVariantMap &request);
     void commandStartAccessPoint(const QVariantMap &request);
+    void commandSetCapabilities(const QVariantMap &request);
+    void commandGetNetworkChanges(const QVariantMap &request);
+    QVariantMap networkChanges(quint32 generation) const;
 
 private slots:
     // Service
@@ -104,12 +184,16 @@ private slots:
 
     // Commands
     void processCommand(const QVariantMap &request);
+    void processRequestQueue();
 
     // Wireless network device
-    void onWirelessDeviceBitRateChanged(const int &bitRate);
     void onWirelessDeviceStateChanged(const NetworkDevice::NetworkDeviceState &state);
     void onWirelessModeChanged(WirelessNetworkDevice::WirelessMode mode);
+    void onAccessPointGenerationChanged();
+    void sendNetworkEvents();
 
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(WirelessService::WirelessServiceCapabilities)
+
 #endif // WIRELESSSERVICE_H
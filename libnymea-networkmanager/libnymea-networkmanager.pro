@@ -22,23 +22,27 @@ DEFINES += VERSION_STRING=\\\"$${VERSION_STRING}\\\"
 
 HEADERS += \
     networkmanager.h \
+    networkmanagerreply.h \
     networkconnection.h \
     networkdevice.h \
     networksettings.h \
     wirednetworkdevice.h \
     wirelessaccesspoint.h \
     wirelessnetworkdevice.h \
-    networkmanagerutils.h
+    networkmanagerutils.h \
+    networkmanagerdbusproxy.h
 
 SOURCES += \
     networkmanager.cpp \
+    networkmanagerreply.cpp \
     networkconnection.cpp \
     networkdevice.cpp \
     networksettings.cpp \
     wirednetworkdevice.cpp \
     wirelessaccesspoint.cpp \
     wirelessnetworkdevice.cpp \
-    networkmanagerutils.cpp
+    networkmanagerutils.cpp \
+    networkmanagerdbusproxy.cpp
 
 lessThan(QT_MAJOR_VERSION, 6):lessThan(QT_MINOR_VERSION, 7) {
     message(Bluetooth LE server functionality not supported with Qt $${QT_VERSION}.)
@@ -51,11 +55,13 @@ lessThan(QT_MAJOR_VERSION, 6):lessThan(QT_MINOR_VERSION, 7) {
         bluetooth/bluetoothserver.h \
         bluetooth/bluetoothuuids.h \
         bluetooth/networkservice.h \
+        bluetooth/transmitqueue.h \
         bluetooth/wirelessservice.h \
 
     SOURCES += \
         bluetooth/bluetoothserver.cpp \
         bluetooth/networkservice.cpp \
+        bluetooth/transmitqueue.cpp \
         bluetooth/wirelessservice.cpp \
 }
 
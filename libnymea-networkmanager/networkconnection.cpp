@@ -27,6 +27,19 @@
     \inmodule nymea-networkmanager
     \ingroup networkmanager
 
+    The summary of the connection, like the id, uuid or type, gets loaded asynchronously once the
+    \l{NetworkConnection} has been created. Reading it before it arrived waits for the pending call.
+    The complete \l{connectionSettings()} are only loaded on first access. Whenever the NetworkManager
+    reports the connection as updated, the summary gets reloaded and the cached settings are dropped.
+
+*/
+
+/*! \fn void NetworkConnection::summaryChanged();
+    This signal will be emitted whenever the summary of this \l{NetworkConnection} has been loaded.
+*/
+
+/*! \fn void NetworkConnection::summaryLoadFailed();
+    This signal will be emitted if the summary of this \l{NetworkConnection} could not be loaded.
 */
 
 #include "networkconnection.h"
@@ -40,36 +53,51 @@ NetworkConnection::NetworkConnection(const QDBusObjectPath &objectPath, QObject
     QObject(parent),
     m_objectPath(objectPath)
 {
-    m_connectionInterface = new QDBusInterface(NetworkManagerUtils::networkManagerServiceString(), m_objectPath.path(), NetworkManagerUtils::connectionsInterfaceString(), QDBusConnection::systemBus(), this);
+    m_connectionInterface = new NetworkManagerDBusProxy(m_objectPath.path(), NetworkManagerUtils::connectionsInterfaceString(), QDBusConnection::systemBus(), this);
     if(!m_connectionInterface->isValid()) {
         qCWarning(dcNetworkManager()) << "Invalid connection dbus interface";
         return;
     }
 
-    QDBusMessage query = m_connectionInterface->call("GetSettings");
-    if(query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcNetworkManager()) << query.errorName() << query.errorMessage();
-        return;
-    }
+    loadSummary();
+}
 
-    if (query.arguments().isEmpty())
-        return;
+/*! Delete this \l{NetworkConnection} in the \l{NetworkManager}. */
+void NetworkConnection::deleteConnection()
+{
+    QDBusPendingReply<> reply = deleteConnectionAsync();
+    reply.waitForFinished();
+    if (reply.isError())
+        qCWarning(dcNetworkManager()) << reply.error().name() << reply.error().message();
+
+}
+
+/*! Delete this \l{NetworkConnection} without blocking. The returned pending reply finishes once NetworkManager removed the connection. */
+QDBusPendingReply<> NetworkConnection::deleteConnectionAsync()
+{
+    return m_connectionInterface->asyncCall("Delete");
+}
 
-    const QDBusArgument &argument = query.arguments().at(0).value<QDBusArgument>();
-    m_connectionSettings = qdbus_cast<ConnectionSettings>(argument);
+/*! Replaces the settings of this \l{NetworkConnection} with the given \a settings without blocking.
 
-//    foreach (const QVariant &connectionVariant, m_connectionSettings.values()) {
-//        qCDebug(dcNetworkManager()) << connectionVariant;
-//    }
+    The \a flags define how the NetworkManager stores the new settings. Passing empty \a settings only applies the \a flags, i.e. in order to persist an in-memory connection.
+    Note: available since NetworkManager 1.12.
+*/
+QDBusPendingReply<QVariantMap> NetworkConnection::updateAsync(const ConnectionSettings &settings, UpdateFlags flags)
+{
+    return m_connectionInterface->asyncCall("Update2", QVariant::fromValue(settings), static_cast<uint>(flags), QVariantMap());
 }
 
-/*! Delete this \l{NetworkConnection} in the \l{NetworkManager}. */
-void NetworkConnection::deleteConnection()
+/*! Returns the current settings of this \l{NetworkConnection} without blocking. The cached settings are not affected. */
+QDBusPendingReply<ConnectionSettings> NetworkConnection::getSettingsAsync()
 {
-    QDBusMessage query = m_connectionInterface->call("Delete");
-    if(query.type() != QDBusMessage::ReplyMessage)
-        qCWarning(dcNetworkManager()) << query.errorName() << query.errorMessage();
+    return m_connectionInterface->asyncCall("GetSettings");
+}
 
+/*! Returns the secrets of the setting with the given \a settingName, i.e. "802-11-wireless-security", without blocking. */
+QDBusPendingReply<ConnectionSettings> NetworkConnection::getSecretsAsync(const QString &settingName)
+{
+    return m_connectionInterface->asyncCall("GetSecrets", settingName);
 }
 
 void NetworkConnection::registerTypes()
@@ -84,52 +112,144 @@ QDBusObjectPath NetworkConnection::objectPath() const
     return m_objectPath;
 }
 
-/*! Returns the connection settings of this \l{NetworkConnection}. */
+/*! Returns the connection settings of this \l{NetworkConnection}. The settings get loaded on first access and cached until the connection gets updated.
+
+    \sa getSettingsAsync()
+*/
 ConnectionSettings NetworkConnection::connectionSettings() const
 {
+    if (m_connectionSettingsLoaded)
+        return m_connectionSettings;
+
+    QDBusPendingReply<ConnectionSettings> reply = m_connectionInterface->asyncCall("GetSettings");
+    reply.waitForFinished();
+    if (reply.isError()) {
+        qCWarning(dcNetworkManager()) << reply.error().name() << reply.error().message();
+        return ConnectionSettings();
+    }
+
+    m_connectionSettings = reply.value();
+    m_connectionSettingsLoaded = true;
     return m_connectionSettings;
 }
 
 /*! Returns the id of this \l{NetworkConnection}. */
 QString NetworkConnection::id() const
 {
-    return m_connectionSettings.value("connection").value("id").toString();
+    waitForSummary();
+    return m_id;
 }
 
 /*! Returns the name of this \l{NetworkConnection}. */
 QString NetworkConnection::name() const
 {
-    return m_connectionSettings.value("connection").value("name").toString();
+    waitForSummary();
+    return m_name;
 }
 
 /*! Returns the type of this \l{NetworkConnection}. */
 QString NetworkConnection::type() const
 {
-    return m_connectionSettings.value("connection").value("type").toString();
+    waitForSummary();
+    return m_type;
 }
 
 /*! Returns the uuid of this \l{NetworkConnection}. */
 QUuid NetworkConnection::uuid() const
 {
-    return m_connectionSettings.value("connection").value("uuid").toUuid();
+    waitForSummary();
+    return m_uuid;
 }
 
 /*! Returns the interface name of this \l{NetworkConnection}. */
 QString NetworkConnection::interfaceName() const
 {
-    return m_connectionSettings.value("connection").value("interface-name").toString();
+    waitForSummary();
+    return m_interfaceName;
 }
 
 /*! Returns true if this \l{NetworkConnection} will autoconnect if available. */
 bool NetworkConnection::autoconnect() const
 {
-    return m_connectionSettings.value("connection").value("autoconnect").toBool();
+    waitForSummary();
+    return m_autoconnect;
 }
 
 /*! Returns the timestamp of this \l{NetworkConnection} from the last connection. */
 QDateTime NetworkConnection::timeStamp() const
 {
-    return QDateTime::fromSecsSinceEpoch(m_connectionSettings.value("connection").value("timestamp").toUInt());
+    waitForSummary();
+    return QDateTime::fromSecsSinceEpoch(m_timeStamp);
+}
+
+/*! Returns the SSID of this \l{NetworkConnection} if it is a wireless connection. */
+QByteArray NetworkConnection::ssid() const
+{
+    waitForSummary();
+    return m_ssid;
+}
+
+/*! Returns the wireless mode of this \l{NetworkConnection}, i.e. "infrastructure" or "ap", if it is a wireless connection. */
+QString NetworkConnection::wirelessMode() const
+{
+    waitForSummary();
+    return m_wirelessMode;
+}
+
+void NetworkConnection::loadSummary()
+{
+    m_summaryWatcher = new QDBusPendingCallWatcher(getSettingsAsync(), this);
+    connect(m_summaryWatcher.data(), &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *call){
+        call->deleteLater();
+
+        // Note: a newer request has been started in the meantime, its reply will contain the current settings
+        if (call != m_summaryWatcher.data())
+            return;
+
+        m_summaryWatcher.clear();
+
+        QDBusPendingReply<ConnectionSettings> reply = *call;
+        if (reply.isError()) {
+            qCWarning(dcNetworkManager()) << "Could not load connection settings of" << m_objectPath.path() << reply.error().name() << reply.error().message();
+            emit summaryLoadFailed();
+            return;
+        }
+
+        processSettings(reply.value());
+    });
+}
+
+void NetworkConnection::reload()
+{
+    m_connectionSettings.clear();
+    m_connectionSettingsLoaded = false;
+    loadSummary();
+}
+
+void NetworkConnection::waitForSummary() const
+{
+    // Note: the watcher delivers the finished signal while waiting, the summary is available afterwards
+    if (!m_summaryWatcher.isNull())
+        m_summaryWatcher->waitForFinished();
+}
+
+void NetworkConnection::processSettings(const ConnectionSettings &settings)
+{
+    // Note: only the summary is kept, the complete settings get loaded on first access
+    const QVariantMap connectionSettings = settings.value("connection");
+    m_id = connectionSettings.value("id").toString();
+    m_name = connectionSettings.value("name").toString();
+    m_type = connectionSettings.value("type").toString();
+    m_uuid = connectionSettings.value("uuid").toUuid();
+    m_interfaceName = connectionSettings.value("interface-name").toString();
+    m_autoconnect = connectionSettings.value("autoconnect").toBool();
+    m_timeStamp = connectionSettings.value("timestamp").toUInt();
+
+    const QVariantMap wirelessSettings = settings.value("802-11-wireless");
+    m_ssid = wirelessSettings.value("ssid").toByteArray();
+    m_wirelessMode = wirelessSettings.value("mode").toString();
+
+    emit summaryChanged();
 }
 
 QDebug operator<<(QDebug debug, NetworkConnection *networkConnection)
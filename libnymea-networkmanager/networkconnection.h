@@ -28,22 +28,47 @@
 #include <QUuid>
 #include <QDebug>
 #include <QObject>
+#include <QPointer>
 #include <QDateTime>
 #include <QDBusMetaType>
 #include <QDBusObjectPath>
 #include <QDBusConnection>
-#include <QDBusInterface>
 #include <QDBusArgument>
+#include <QDBusPendingReply>
+#include <QDBusPendingCallWatcher>
+
+#include "networkmanagerdbusproxy.h"
 
 typedef QMap<QString, QVariantMap> ConnectionSettings;
 
 class NetworkConnection : public QObject
 {
     Q_OBJECT
+    friend class NetworkSettings;
+
 public:
+    enum UpdateFlag {
+        UpdateFlagNone              = 0x00,
+        UpdateFlagToDisk            = 0x01,
+        UpdateFlagInMemory          = 0x02,
+        UpdateFlagInMemoryDetached  = 0x04,
+        UpdateFlagInMemoryOnly      = 0x08,
+        UpdateFlagVolatile          = 0x10,
+        UpdateFlagBlockAutoconnect  = 0x20,
+        UpdateFlagNoReapply         = 0x40
+    };
+    Q_ENUM(UpdateFlag)
+    Q_DECLARE_FLAGS(UpdateFlags, UpdateFlag)
+    Q_FLAG(UpdateFlags)
+
     explicit NetworkConnection(const QDBusObjectPath &objectPath, QObject *parent = nullptr);
 
     void deleteConnection();
+    QDBusPendingReply<> deleteConnectionAsync();
+
+    QDBusPendingReply<QVariantMap> updateAsync(const ConnectionSettings &settings, UpdateFlags flags = UpdateFlagToDisk);
+    QDBusPendingReply<ConnectionSettings> getSettingsAsync();
+    QDBusPendingReply<ConnectionSettings> getSecretsAsync(const QString &settingName);
 
     static void registerTypes();
 
@@ -57,15 +82,41 @@ public:
     QString interfaceName() const;
     bool autoconnect() const;
     QDateTime timeStamp() const;
+    QByteArray ssid() const;
+    QString wirelessMode() const;
+
+signals:
+    void summaryChanged();
+    void summaryLoadFailed();
 
 private:
     QDBusObjectPath m_objectPath;
-    QDBusInterface *m_connectionInterface = nullptr;
+    NetworkManagerDBusProxy *m_connectionInterface = nullptr;
+    QPointer<QDBusPendingCallWatcher> m_summaryWatcher;
+
+    // Summary of the settings, loaded asynchronously together with the settings
+    QString m_id;
+    QString m_name;
+    QString m_type;
+    QUuid m_uuid;
+    QString m_interfaceName;
+    bool m_autoconnect = false;
+    uint m_timeStamp = 0;
+    QByteArray m_ssid;
+    QString m_wirelessMode;
+
+    // Note: loaded on first access of connectionSettings(), dropped once the connection has been updated
+    mutable ConnectionSettings m_connectionSettings;
+    mutable bool m_connectionSettingsLoaded = false;
 
-    ConnectionSettings m_connectionSettings;
+    void loadSummary();
+    void reload();
+    void waitForSummary() const;
+    void processSettings(const ConnectionSettings &settings);
 };
 
 Q_DECLARE_METATYPE(ConnectionSettings)
+Q_DECLARE_OPERATORS_FOR_FLAGS(NetworkConnection::UpdateFlags)
 QDebug operator<<(QDebug debug, NetworkConnection *networkConnection);
 
 #endif // NETWORKCONNECTION_H
@@ -136,51 +136,64 @@
 */
 
 
+/*! \enum NetworkDevice::DeviceChange
+    \value DeviceChangeNone
+    \value DeviceChangeState
+    \value DeviceChangeIpAddresses
+    \value DeviceChangeBitRate
+    \value DeviceChangePluggedIn
+    \value DeviceChangeWirelessMode
+    \value DeviceChangeWirelessCapabilities
+    \value DeviceChangeLastScan
+    \value DeviceChangeActiveAccessPoint
+    \value DeviceChangeSignalStrength
+*/
+
 /*! \fn void NetworkDevice::deviceChanged();
     This signal will be emitted when the properties of this \l{NetworkDevice} have changed.
+
+    Changes are coalesced, the signal will be emitted at most once per \l{changeNotificationInterval()}.
+*/
+
+/*! \fn void NetworkDevice::devicePropertiesChanged(NetworkDevice::DeviceChanges changes);
+    This signal will be emitted together with \l{deviceChanged()} and contains the \a changes collected since the last notification.
 */
 
 #include "networkdevice.h"
 
 #include <QDebug>
 #include <QMetaEnum>
+#include <QDBusPendingCallWatcher>
 
 /*! Constructs a new \l{NetworkDevice} with the given dbus \a objectPath and \a parent. */
 NetworkDevice::NetworkDevice(const QDBusObjectPath &objectPath, QObject *parent) :
     QObject(parent),
     m_objectPath(objectPath)
 {
-    QDBusConnection systemBus = QDBusConnection::systemBus();
-    if (!systemBus.isConnected()) {
-        qCWarning(dcNetworkManager()) << "NetworkDevice: System DBus not connected";
-        return;
-    }
-
-    m_networkDeviceInterface = new QDBusInterface(NetworkManagerUtils::networkManagerServiceString(), m_objectPath.path(), NetworkManagerUtils::deviceInterfaceString(), QDBusConnection::systemBus(), this);
-    if(!m_networkDeviceInterface->isValid()) {
-        qCWarning(dcNetworkManager()) << "NetworkDevice: Invalid DBus device interface" << m_objectPath.path();
+    if (!initInterface())
         return;
-    }
 
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), m_objectPath.path(), NetworkManagerUtils::deviceInterfaceString(), "StateChanged", this, SLOT(onStateChanged(uint,uint,uint)));
+    const QVariantMap properties = m_networkDeviceInterface->readProperties();
+    loadProperties(properties);
+    m_ipv4Addresses = readIpAddresses(properties.value("Ip4Config"), "org.freedesktop.NetworkManager.IP4Config");
+    m_ipv6Addresses = readIpAddresses(properties.value("Ip6Config"), "org.freedesktop.NetworkManager.IP6Config");
+}
 
-    m_udi = m_networkDeviceInterface->property("Udi").toString();
-    m_interface = m_networkDeviceInterface->property("Interface").toString();
-    m_ipInterface = m_networkDeviceInterface->property("IpInterface").toString();
-    m_driver = m_networkDeviceInterface->property("Driver").toString();
-    m_driverVersion = m_networkDeviceInterface->property("DriverVersion").toString();
-    m_firmwareVersion = m_networkDeviceInterface->property("FirmwareVersion").toString();
-    m_physicalPortId = m_networkDeviceInterface->property("PhysicalPortId").toString();
-    m_mtu = m_networkDeviceInterface->property("Mtu").toUInt();
-    m_metered = m_networkDeviceInterface->property("Metered").toUInt();
-    m_autoconnect = m_networkDeviceInterface->property("Autoconnect").toBool();
+/*! Constructs a new \l{NetworkDevice} with the given dbus \a objectPath and \a parent.
 
-    m_deviceState = NetworkDeviceState(m_networkDeviceInterface->property("State").toUInt());
-    m_deviceType = NetworkDeviceType(m_networkDeviceInterface->property("DeviceType").toUInt());
+    The device properties and the IP configurations are taken from the given \a managedObjects instead of reading them one by one from the bus.
+*/
+NetworkDevice::NetworkDevice(const QDBusObjectPath &objectPath, const NMManagedObjects &managedObjects, QObject *parent) :
+    QObject(parent),
+    m_objectPath(objectPath)
+{
+    if (!initInterface())
+        return;
 
-    m_activeConnection = qdbus_cast<QDBusObjectPath>(m_networkDeviceInterface->property("ActiveConnection"));
-    m_ipv4Addresses = readIpAddresses("Ip4Config", "org.freedesktop.NetworkManager.IP4Config");
-    m_ipv6Addresses = readIpAddresses("Ip6Config", "org.freedesktop.NetworkManager.IP6Config");
+    const QVariantMap properties = managedObjects.value(m_objectPath).value(NetworkManagerUtils::deviceInterfaceString());
+    loadProperties(properties);
+    m_ipv4Addresses = readIpAddresses(properties.value("Ip4Config"), "org.freedesktop.NetworkManager.IP4Config", managedObjects);
+    m_ipv6Addresses = readIpAddresses(properties.value("Ip6Config"), "org.freedesktop.NetworkManager.IP6Config", managedObjects);
 }
 
 /*! Returns the dbus object path of this \l{NetworkDevice}. */
@@ -300,12 +313,33 @@ QList<QDBusObjectPath> NetworkDevice::availableConnections() const
 /*! Disconnect the current connection from this \l{NetworkDevice}. */
 void NetworkDevice::disconnectDevice()
 {
-    QDBusMessage query = m_networkDeviceInterface->call("Disconnect");
-    if(query.type() != QDBusMessage::ReplyMessage)
-        qCWarning(dcNetworkManager()) << query.errorName() << query.errorMessage();
+    QDBusPendingReply<> reply = disconnectDeviceAsync();
+    reply.waitForFinished();
+    if (reply.isError())
+        qCWarning(dcNetworkManager()) << reply.error().name() << reply.error().message();
 
 }
 
+/*! Disconnect the current connection from this \l{NetworkDevice} without blocking. The returned pending reply finishes once NetworkManager processed the request. */
+QDBusPendingReply<> NetworkDevice::disconnectDeviceAsync()
+{
+    return m_networkDeviceInterface->asyncCall("Disconnect");
+}
+
+/*! Returns the interval in milliseconds used to coalesce change notifications of this \l{NetworkDevice}. */
+int NetworkDevice::changeNotificationInterval() const
+{
+    return m_changeNotificationInterval;
+}
+
+/*! Sets the interval in milliseconds used to coalesce change notifications of this \l{NetworkDevice} to \a changeNotificationInterval. 0 disables the coalescing. */
+void NetworkDevice::setChangeNotificationInterval(int changeNotificationInterval)
+{
+    m_changeNotificationInterval = qMax(0, changeNotificationInterval);
+    if (m_changeNotificationTimer)
+        m_changeNotificationTimer->setInterval(m_changeNotificationInterval);
+}
+
 /*! Returns the human readable device type string of the given \a deviceType. \sa NetworkDeviceType, */
 QString NetworkDevice::deviceTypeToString(const NetworkDevice::NetworkDeviceType &deviceType)
 {
@@ -333,28 +367,79 @@ QString NetworkDevice::deviceStateReasonToString(const NetworkDevice::NetworkDev
     return QString(metaEnum.valueToKey(deviceStateReason));
 }
 
-QStringList NetworkDevice::readIpAddresses(const QString &property, const QString &interface)
+bool NetworkDevice::initInterface()
 {
-    QStringList ret;
-    QDBusObjectPath configPath = qdbus_cast<QDBusObjectPath>(m_networkDeviceInterface->property(property.toUtf8()));
+    QDBusConnection systemBus = QDBusConnection::systemBus();
+    if (!systemBus.isConnected()) {
+        qCWarning(dcNetworkManager()) << "NetworkDevice: System DBus not connected";
+        return false;
+    }
 
-    if (configPath.path() != "/") {
-        QDBusInterface iface(NetworkManagerUtils::networkManagerServiceString(), configPath.path(), "org.freedesktop.DBus.Properties", QDBusConnection::systemBus());
+    m_networkDeviceInterface = new NetworkManagerDBusProxy(m_objectPath.path(), NetworkManagerUtils::deviceInterfaceString(), systemBus, this);
+    if(!m_networkDeviceInterface->isValid()) {
+        qCWarning(dcNetworkManager()) << "NetworkDevice: Invalid DBus device interface" << m_objectPath.path();
+        return false;
+    }
 
-        QDBusMessage reply = iface.call("Get", interface, "AddressData");
-        if (reply.arguments().isEmpty()) {
-            return ret;
-        }
-        QVariant v = reply.arguments().first();
-        QDBusArgument arg = v.value<QDBusVariant>().variant().value<QDBusArgument>();
-
-        arg.beginArray();
-        while(!arg.atEnd()) {
-            QVariantMap m;
-            arg >> m;
-            ret.append(m.value("address").toString());
-        }
+    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), m_objectPath.path(), NetworkManagerUtils::deviceInterfaceString(), "StateChanged", this, SLOT(onStateChanged(uint,uint,uint)));
+    return true;
+}
+
+void NetworkDevice::loadProperties(const QVariantMap &properties)
+{
+    m_udi = properties.value("Udi").toString();
+    m_interface = properties.value("Interface").toString();
+    m_ipInterface = properties.value("IpInterface").toString();
+    m_driver = properties.value("Driver").toString();
+    m_driverVersion = properties.value("DriverVersion").toString();
+    m_firmwareVersion = properties.value("FirmwareVersion").toString();
+    m_physicalPortId = properties.value("PhysicalPortId").toString();
+    m_mtu = properties.value("Mtu").toUInt();
+    m_metered = properties.value("Metered").toUInt();
+    m_autoconnect = properties.value("Autoconnect").toBool();
+
+    m_deviceState = NetworkDeviceState(properties.value("State").toUInt());
+    m_deviceType = NetworkDeviceType(properties.value("DeviceType").toUInt());
+
+    m_activeConnection = qdbus_cast<QDBusObjectPath>(properties.value("ActiveConnection"));
+}
+
+QStringList NetworkDevice::readIpAddresses(const QVariant &configPath, const QString &interface)
+{
+    QDBusObjectPath configObjectPath = qdbus_cast<QDBusObjectPath>(configPath);
+    if (configObjectPath.path().isEmpty() || configObjectPath.path() == "/")
+        return QStringList();
+
+    NetworkManagerDBusProxy configProxy(configObjectPath.path(), interface);
+    QVariant addressData = configProxy.readProperty("AddressData");
+    if (!addressData.isValid())
+        return QStringList();
+
+    return parseAddressData(addressData);
+}
+
+QStringList NetworkDevice::readIpAddresses(const QVariant &configPath, const QString &interface, const NMManagedObjects &managedObjects)
+{
+    // Note: "/" means there is no IP configuration. Unknown paths have no entry in the managed objects and result in an empty list.
+    const QVariantMap properties = managedObjects.value(qdbus_cast<QDBusObjectPath>(configPath)).value(interface);
+    if (!properties.contains("AddressData"))
+        return QStringList();
+
+    return parseAddressData(properties.value("AddressData"));
+}
+
+QStringList NetworkDevice::parseAddressData(const QVariant &addressData)
+{
+    QStringList ret;
+    QDBusArgument arg = addressData.value<QDBusArgument>();
+
+    arg.beginArray();
+    while(!arg.atEnd()) {
+        QVariantMap m;
+        arg >> m;
+        ret.append(m.value("address").toString());
     }
+    arg.endArray();
     return ret;
 }
 
@@ -365,14 +450,117 @@ void NetworkDevice::onStateChanged(uint newState, uint oldState, uint reason)
 
 
     if (m_deviceState != NetworkDeviceState(newState)) {
-        m_ipv4Addresses = readIpAddresses("Ip4Config", "org.freedesktop.NetworkManager.IP4Config");
-        m_ipv6Addresses = readIpAddresses("Ip6Config", "org.freedesktop.NetworkManager.IP6Config");
-        emit deviceChanged();
-
         m_deviceState = NetworkDeviceState(newState);
         emit stateChanged(m_deviceState);
+        notifyDeviceChanged(DeviceChangeState);
+
+        // Note: the IP addresses will be notified once they arrived
+        refreshIpAddresses();
+    }
+
+}
+
+void NetworkDevice::refreshIpAddresses()
+{
+    const quint32 request = ++m_ipAddressesRequest;
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_networkDeviceInterface->readPropertiesAsync(), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, request](QDBusPendingCallWatcher *call){
+        call->deleteLater();
+        if (request != m_ipAddressesRequest)
+            return;
+
+        QDBusPendingReply<QVariantMap> reply = *call;
+        if (reply.isError()) {
+            qCWarning(dcNetworkManager()) << "Could not read properties of" << m_interface << reply.error().name() << reply.error().message();
+            return;
+        }
+
+        const QVariantMap properties = reply.value();
+        m_activeConnection = qdbus_cast<QDBusObjectPath>(properties.value("ActiveConnection"));
+
+        m_pendingIpConfigurations = 0;
+        m_pendingIpv4Addresses.clear();
+        m_pendingIpv6Addresses.clear();
+        readIpConfiguration(request, qdbus_cast<QDBusObjectPath>(properties.value("Ip4Config")), "org.freedesktop.NetworkManager.IP4Config", false);
+        readIpConfiguration(request, qdbus_cast<QDBusObjectPath>(properties.value("Ip6Config")), "org.freedesktop.NetworkManager.IP6Config", true);
+        if (m_pendingIpConfigurations == 0)
+            applyIpAddresses();
+    });
+}
+
+void NetworkDevice::readIpConfiguration(quint32 request, const QDBusObjectPath &configPath, const QString &interface, bool ipv6)
+{
+    // Note: "/" means there is no IP configuration
+    if (configPath.path().isEmpty() || configPath.path() == "/")
+        return;
+
+    m_pendingIpConfigurations++;
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(NetworkManagerDBusProxy::readObjectPropertiesAsync(configPath.path(), interface), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, request, ipv6](QDBusPendingCallWatcher *call){
+        call->deleteLater();
+        if (request != m_ipAddressesRequest)
+            return;
+
+        QDBusPendingReply<QVariantMap> reply = *call;
+        if (reply.isError()) {
+            qCWarning(dcNetworkManager()) << "Could not read IP configuration of" << m_interface << reply.error().name() << reply.error().message();
+        } else if (reply.value().contains("AddressData")) {
+            if (ipv6) {
+                m_pendingIpv6Addresses = parseAddressData(reply.value().value("AddressData"));
+            } else {
+                m_pendingIpv4Addresses = parseAddressData(reply.value().value("AddressData"));
+            }
+        }
+
+        if (--m_pendingIpConfigurations == 0)
+            applyIpAddresses();
+    });
+}
+
+void NetworkDevice::applyIpAddresses()
+{
+    if (m_ipv4Addresses == m_pendingIpv4Addresses && m_ipv6Addresses == m_pendingIpv6Addresses)
+        return;
+
+    m_ipv4Addresses = m_pendingIpv4Addresses;
+    m_ipv6Addresses = m_pendingIpv6Addresses;
+    notifyDeviceChanged(DeviceChangeIpAddresses);
+}
+
+void NetworkDevice::onChangeNotificationTimeout()
+{
+    if (m_pendingChanges == DeviceChangeNone)
+        return;
+
+    DeviceChanges changes = m_pendingChanges;
+    m_pendingChanges = DeviceChangeNone;
+    emit devicePropertiesChanged(changes);
+    emit deviceChanged();
+}
+
+/*! Collects the given \a changes and emits them with the next change notification. */
+void NetworkDevice::notifyDeviceChanged(DeviceChanges changes)
+{
+    if (changes == DeviceChangeNone)
+        return;
+
+    m_pendingChanges |= changes;
+
+    if (m_changeNotificationInterval == 0) {
+        onChangeNotificationTimeout();
+        return;
+    }
+
+    if (!m_changeNotificationTimer) {
+        m_changeNotificationTimer = new QTimer(this);
+        m_changeNotificationTimer->setSingleShot(true);
+        m_changeNotificationTimer->setInterval(m_changeNotificationInterval);
+        connect(m_changeNotificationTimer, &QTimer::timeout, this, &NetworkDevice::onChangeNotificationTimeout);
     }
 
+    // Note: do not restart a running timer, otherwise continuous changes would never be notified
+    if (!m_changeNotificationTimer->isActive())
+        m_changeNotificationTimer->start();
 }
 
 QDebug operator<<(QDebug debug, NetworkDevice *device)
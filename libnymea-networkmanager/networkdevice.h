@@ -26,14 +26,16 @@
 #define NETWORKDEVICE_H
 
 #include <QDebug>
+#include <QTimer>
 #include <QObject>
 #include <QDBusConnection>
-#include <QDBusInterface>
 #include <QDBusMessage>
 #include <QDBusContext>
 #include <QDBusArgument>
+#include <QDBusPendingReply>
 
 #include "networkmanagerutils.h"
+#include "networkmanagerdbusproxy.h"
 
 class NetworkDevice : public QObject
 {
@@ -150,7 +152,23 @@ public:
     };
     Q_ENUM(NetworkDeviceType)
 
+    enum DeviceChange {
+        DeviceChangeNone = 0x0000,
+        DeviceChangeState = 0x0001,
+        DeviceChangeIpAddresses = 0x0002,
+        DeviceChangeBitRate = 0x0004,
+        DeviceChangePluggedIn = 0x0008,
+        DeviceChangeWirelessMode = 0x0010,
+        DeviceChangeWirelessCapabilities = 0x0020,
+        DeviceChangeLastScan = 0x0040,
+        DeviceChangeActiveAccessPoint = 0x0080,
+        DeviceChangeSignalStrength = 0x0100
+    };
+    Q_DECLARE_FLAGS(DeviceChanges, DeviceChange)
+    Q_FLAG(DeviceChanges)
+
     explicit NetworkDevice(const QDBusObjectPath &objectPath, QObject *parent = nullptr);
+    explicit NetworkDevice(const QDBusObjectPath &objectPath, const NMManagedObjects &managedObjects, QObject *parent = nullptr);
 
     QDBusObjectPath objectPath() const;
 
@@ -178,6 +196,10 @@ public:
     QList<QDBusObjectPath> availableConnections() const;
 
     void disconnectDevice();
+    QDBusPendingReply<> disconnectDeviceAsync();
+
+    int changeNotificationInterval() const;
+    void setChangeNotificationInterval(int changeNotificationInterval);
 
     static QString deviceTypeToString(const NetworkDeviceType &deviceType);
     static QString deviceStateToString(const NetworkDeviceState &deviceState);
@@ -185,16 +207,28 @@ public:
 
 signals:
     void deviceChanged();
+    void devicePropertiesChanged(NetworkDevice::DeviceChanges changes);
     void stateChanged(const NetworkDeviceState &state);
 
+protected:
+    void notifyDeviceChanged(DeviceChanges changes);
+
 private slots:
     void onStateChanged(uint newState, uint oldState, uint reason);
+    void onChangeNotificationTimeout();
 
 private:
-    QStringList readIpAddresses(const QString &property, const QString &interface);
+    bool initInterface();
+    void loadProperties(const QVariantMap &properties);
+    static QStringList readIpAddresses(const QVariant &configPath, const QString &interface);
+    static QStringList readIpAddresses(const QVariant &configPath, const QString &interface, const NMManagedObjects &managedObjects);
+    static QStringList parseAddressData(const QVariant &addressData);
+    void refreshIpAddresses();
+    void readIpConfiguration(quint32 request, const QDBusObjectPath &configPath, const QString &interface, bool ipv6);
+    void applyIpAddresses();
 
 private:
-    QDBusInterface *m_networkDeviceInterface = nullptr;
+    NetworkManagerDBusProxy *m_networkDeviceInterface = nullptr;
     QDBusObjectPath m_objectPath;
 
     // Device properties
@@ -218,8 +252,21 @@ private:
 
     QList<QDBusObjectPath> m_availableConnections;
 
+    // Asynchronous IP address refresh, a newer request supersedes the pending one
+    quint32 m_ipAddressesRequest = 0;
+    int m_pendingIpConfigurations = 0;
+    QStringList m_pendingIpv4Addresses;
+    QStringList m_pendingIpv6Addresses;
+
+    // Change notification coalescing
+    QTimer *m_changeNotificationTimer = nullptr;
+    int m_changeNotificationInterval = 250;
+    DeviceChanges m_pendingChanges = DeviceChangeNone;
+
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(NetworkDevice::DeviceChanges)
+
 QDebug operator<<(QDebug debug, NetworkDevice *device);
 
 #endif // NETWORKDEVICE_H
@@ -33,6 +33,7 @@
 
 #include "networkmanager.h"
 #include "networkconnection.h"
+#include "networkmanagerreply.h"
 
 #include <QUuid>
 #include <QDebug>
@@ -88,6 +89,12 @@ QList<WiredNetworkDevice *> NetworkManager::wiredNetworkDevices() const
     return m_wiredNetworkDevices.values();
 }
 
+/*! Returns the list of \l{NetworkDevice}{NetworkDevices} of the given \a deviceType from this \l{NetworkManager}. */
+QList<NetworkDevice *> NetworkManager::networkDevices(NetworkDevice::NetworkDeviceType deviceType) const
+{
+    return m_networkDevicesByType.value(deviceType);
+}
+
 /*! Returns the \l{NetworkSettings} from this \l{NetworkManager}. */
 NetworkSettings *NetworkManager::networkSettings() const
 {
@@ -97,11 +104,27 @@ NetworkSettings *NetworkManager::networkSettings() const
 /*! Returns the \l{NetworkDevice} with the given \a interface from this \l{NetworkManager}. If there is no such \a interface returns nullptr. */
 NetworkDevice *NetworkManager::getNetworkDevice(const QString &interface)
 {
-    foreach (NetworkDevice *device, m_networkDevices.values()) {
-        if (device->interface() == interface)
-            return device;
-    }
-    return nullptr;
+    return m_networkDevicesByInterface.value(interface);
+}
+
+/*! Returns the \l{WirelessNetworkDevice} with the given \a interface from this \l{NetworkManager}. If there is no such wireless \a interface returns nullptr. */
+WirelessNetworkDevice *NetworkManager::getWirelessNetworkDevice(const QString &interface) const
+{
+    NetworkDevice *networkDevice = m_networkDevicesByInterface.value(interface);
+    if (!networkDevice)
+        return nullptr;
+
+    return m_wirelessNetworkDevices.value(networkDevice->objectPath());
+}
+
+/*! Returns the \l{WiredNetworkDevice} with the given \a interface from this \l{NetworkManager}. If there is no such wired \a interface returns nullptr. */
+WiredNetworkDevice *NetworkManager::getWiredNetworkDevice(const QString &interface) const
+{
+    NetworkDevice *networkDevice = m_networkDevicesByInterface.value(interface);
+    if (!networkDevice)
+        return nullptr;
+
+    return m_wiredNetworkDevices.value(networkDevice->objectPath());
 }
 
 /*! Returns the version of the running \l{NetworkManager}. */
@@ -128,29 +151,41 @@ NetworkManager::NetworkManagerConnectivityState NetworkManager::connectivityStat
     return m_connectivityState;
 }
 
-/*! Connect the given \a interface to a wifi network with the given \a ssid and \a password. Returns the \l{NetworkManagerError} to inform about the result. \sa NetworkManagerError, */
-NetworkManager::NetworkManagerError NetworkManager::connectWifi(const QString &interface, const QString &ssid, const QString &password, AuthAlgorithm authAlgorithm, KeyManagement keyManagement, bool hidden)
+/*! Connect the given \a interface to a wifi network with the given \a ssid and \a password. Returns the \l{NetworkManagerError} to inform about the result.
+
+    The \a persistence defines if the connection profile gets written to disk right away, once the connection has been activated or never.
+    Note: in-memory profiles require NetworkManager 1.16 or newer, older versions always write the profile to disk.
+
+    \sa NetworkManagerError,
+*/
+NetworkManager::NetworkManagerError NetworkManager::connectWifi(const QString &interface, const QString &ssid, const QString &password, AuthAlgorithm authAlgorithm, KeyManagement keyManagement, bool hidden, ConnectionPersistence persistence)
+{
+    NetworkManagerReply *reply = connectWifiAsync(interface, ssid, password, authAlgorithm, keyManagement, hidden, persistence);
+    reply->waitForFinished();
+    return reply->error();
+}
+
+/*! Connect the given \a interface to a wifi network with the given \a ssid and \a password without blocking.
+
+    Returns a \l{NetworkManagerReply} which finishes once the connection has been activated or the request failed. \sa connectWifi(),
+*/
+NetworkManagerReply *NetworkManager::connectWifiAsync(const QString &interface, const QString &ssid, const QString &password, AuthAlgorithm authAlgorithm, KeyManagement keyManagement, bool hidden, ConnectionPersistence persistence)
 {
     // Check interface
     if (!getNetworkDevice(interface))
-        return NetworkManagerErrorNetworkInterfaceNotFound;
+        return createReply(NetworkManagerErrorNetworkInterfaceNotFound);
 
     // Get wirelessNetworkDevice
-    WirelessNetworkDevice *wirelessNetworkDevice = nullptr;
-    foreach (WirelessNetworkDevice *networkDevice, wirelessNetworkDevices()) {
-        if (networkDevice->interface() == interface) {
-            wirelessNetworkDevice = networkDevice;
-        }
-    }
+    WirelessNetworkDevice *wirelessNetworkDevice = getWirelessNetworkDevice(interface);
 
     if (!wirelessNetworkDevice)
-        return NetworkManagerErrorInvalidNetworkDeviceType;
+        return createReply(NetworkManagerErrorInvalidNetworkDeviceType);
 
     if (!hidden) {
         // Get the access point object path
         WirelessAccessPoint *accessPoint = wirelessNetworkDevice->getAccessPoint(ssid);
         if (!accessPoint) {
-            return NetworkManagerErrorAccessPointNotFound;
+            return createReply(NetworkManagerErrorAccessPointNotFound);
         }
 
         qCDebug(dcNetworkManager()) << "Connecting to" << accessPoint;
@@ -213,50 +248,38 @@ NetworkManager::NetworkManagerError NetworkManager::connectWifi(const QString &i
         settings.insert("802-11-wireless-security", wirelessSecuritySettings);
     }
 
-    // Remove old configuration (if there is any)
-    foreach (NetworkConnection *connection, m_networkSettings->connections()) {
-        if (connection->id() == connectionSettings.value("id")) {
-            connection->deleteConnection();
-        }
-    }
-
-    // Add connection
-    QDBusObjectPath connectionObjectPath = m_networkSettings->addConnection(settings);
-    if (connectionObjectPath.path().isEmpty())
-        return NetworkManagerErrorWirelessConnectionFailed;
+    return addAndActivateConnection(settings, wirelessNetworkDevice->objectPath(), NetworkManagerErrorWirelessConnectionFailed, persistence);
+}
 
-    // Activate connection
-    QDBusMessage query = m_networkManagerInterface->call("ActivateConnection", QVariant::fromValue(connectionObjectPath), QVariant::fromValue(wirelessNetworkDevice->objectPath()), QVariant::fromValue(QDBusObjectPath("/")));
-    if (query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcNetworkManager()) << query.errorName() << query.errorMessage();
-        return NetworkManagerErrorWirelessConnectionFailed;
-    }
+/*! Start an access point on the given \a interface with the given \a ssid and \a password. Returns the \l{NetworkManagerError} to inform about the result.
 
-    return NetworkManagerErrorNoError;
+    The \a persistence defines if the access point profile gets written to disk. \sa connectWifi(),
+*/
+NetworkManager::NetworkManagerError NetworkManager::startAccessPoint(const QString &interface, const QString &ssid, const QString &password, ConnectionPersistence persistence)
+{
+    NetworkManagerReply *reply = startAccessPointAsync(interface, ssid, password, persistence);
+    reply->waitForFinished();
+    return reply->error();
 }
 
-NetworkManager::NetworkManagerError NetworkManager::startAccessPoint(const QString &interface, const QString &ssid, const QString &password)
+/*! Start an access point on the given \a interface with the given \a ssid and \a password without blocking. \sa startAccessPoint(), */
+NetworkManagerReply *NetworkManager::startAccessPointAsync(const QString &interface, const QString &ssid, const QString &password, ConnectionPersistence persistence)
 {
     qCDebug(dcNetworkManager()) << "Starting access point for" << interface << "SSID:" <<  ssid << "password:" << password;
 
     // Check interface
     if (!getNetworkDevice(interface))
-        return NetworkManagerErrorNetworkInterfaceNotFound;
+        return createReply(NetworkManagerErrorNetworkInterfaceNotFound);
 
     // Get wirelessNetworkDevice
-    WirelessNetworkDevice *wirelessNetworkDevice = nullptr;
-    foreach (WirelessNetworkDevice *networkDevice, wirelessNetworkDevices()) {
-        if (networkDevice->interface() == interface) {
-            wirelessNetworkDevice = networkDevice;
-        }
-    }
+    WirelessNetworkDevice *wirelessNetworkDevice = getWirelessNetworkDevice(interface);
 
     if (!wirelessNetworkDevice)
-        return NetworkManagerErrorInvalidNetworkDeviceType;
+        return createReply(NetworkManagerErrorInvalidNetworkDeviceType);
 
 
     if (!wirelessNetworkDevice->wirelessCapabilities().testFlag(WirelessNetworkDevice::WirelessCapabilityAP))
-        return NetworkManagerErrorUnsupportedFeature;
+        return createReply(NetworkManagerErrorUnsupportedFeature);
 
     // Note: https://developer.gnome.org/NetworkManager/stable/ref-settings.html
 
@@ -296,41 +319,23 @@ NetworkManager::NetworkManagerError NetworkManager::startAccessPoint(const QStri
     settings.insert("ipv6", ipv6Settings);
     settings.insert("802-11-wireless-security", wirelessSecuritySettings);
 
-    // Remove old configuration (if there is any)
-    foreach (NetworkConnection *connection, m_networkSettings->connections()) {
-        if (connection->id() == connectionSettings.value("id")) {
-            connection->deleteConnection();
-        }
-    }
-
-    // Add connection
-    QDBusObjectPath connectionObjectPath = m_networkSettings->addConnection(settings);
-    if (connectionObjectPath.path().isEmpty())
-        return NetworkManagerErrorWirelessConnectionFailed;
-
-
-    qCDebug(dcNetworkManager()) << "Connection added" << connectionObjectPath.path();
-
-    // Activate connection
-    QDBusMessage query = m_networkManagerInterface->call("ActivateConnection",
-                                                         QVariant::fromValue(connectionObjectPath),
-                                                         QVariant::fromValue(wirelessNetworkDevice->objectPath()),
-                                                         QVariant::fromValue(QDBusObjectPath("/")));
-    if (query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcNetworkManager()) << query.errorName() << query.errorMessage();
-        return NetworkManagerErrorWirelessConnectionFailed;
-    }
-
-    return NetworkManagerErrorNoError;
+    return addAndActivateConnection(settings, wirelessNetworkDevice->objectPath(), NetworkManagerErrorWirelessConnectionFailed, persistence);
 }
 
 NetworkManager::NetworkManagerError NetworkManager::createWiredAutoConnection(const QString &interface)
+{
+    NetworkManagerReply *reply = createWiredAutoConnectionAsync(interface);
+    reply->waitForFinished();
+    return reply->error();
+}
+
+NetworkManagerReply *NetworkManager::createWiredAutoConnectionAsync(const QString &interface)
 {
     qCDebug(dcNetworkManager()) << "Creating auto connection for" << interface;
 
     NetworkDevice *networkDevice = getNetworkDevice(interface);
     if (!networkDevice) {
-        return NetworkManagerErrorNetworkInterfaceNotFound;
+        return createReply(NetworkManagerErrorNetworkInterfaceNotFound);
     }
 
     QVariantMap ethernetMode {
@@ -358,44 +363,26 @@ NetworkManager::NetworkManagerError NetworkManager::createWiredAutoConnection(co
     settings.insert("ipv6", ipv6Settings);
     settings.insert("802-3-ethernet", ethernetMode);
 
-    // Remove old configuration (if there is any)
-    foreach (NetworkConnection *connection, m_networkSettings->connections()) {
-        if (connection->id() == connectionSettings.value("id")) {
-            connection->deleteConnection();
-        }
-    }
-
-    // Add connection
-    QDBusObjectPath connectionObjectPath = m_networkSettings->addConnection(settings);
-    if (connectionObjectPath.path().isEmpty())
-        return NetworkManagerErrorUnknownError;
-
-
-    qCDebug(dcNetworkManager()) << "Connection added" << connectionObjectPath.path();
-
-    // Activate connection
-    QDBusMessage query = m_networkManagerInterface->call("ActivateConnection",
-                                                         QVariant::fromValue(connectionObjectPath),
-                                                         QVariant::fromValue(networkDevice->objectPath()),
-                                                         QVariant::fromValue(QDBusObjectPath("/")));
-    if (query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcNetworkManager()) << query.errorName() << query.errorMessage();
-        return NetworkManagerErrorUnknownError;
-    }
-
-    return NetworkManagerErrorNoError;
+    return addAndActivateConnection(settings, networkDevice->objectPath(), NetworkManagerErrorUnknownError);
 }
 
 NetworkManager::NetworkManagerError NetworkManager::createWiredManualConnection(const QString &interface, const QHostAddress &ip, quint8 prefix, const QHostAddress &gateway, const QHostAddress &dns)
+{
+    NetworkManagerReply *reply = createWiredManualConnectionAsync(interface, ip, prefix, gateway, dns);
+    reply->waitForFinished();
+    return reply->error();
+}
+
+NetworkManagerReply *NetworkManager::createWiredManualConnectionAsync(const QString &interface, const QHostAddress &ip, quint8 prefix, const QHostAddress &gateway, const QHostAddress &dns)
 {
     qCDebug(dcNetworkManager()) << "Creating manual connection for" << interface << ip << prefix << gateway << dns;
 
     NetworkDevice *networkDevice = getNetworkDevice(interface);
     if (!networkDevice) {
-        return NetworkManagerErrorNetworkInterfaceNotFound;
+        return createReply(NetworkManagerErrorNetworkInterfaceNotFound);
     }
     if (ip.isNull() || prefix < 8) {
-        return NetworkManagerErrorInvalidConfiguration;
+        return createReply(NetworkManagerErrorInvalidConfiguration);
     }
 
     QVariantMap ethernetMode {
@@ -443,42 +430,23 @@ NetworkManager::NetworkManagerError NetworkManager::createWiredManualConnection(
     settings.insert("ipv6", ipv6Settings);
     settings.insert("802-3-ethernet", ethernetMode);
 
-    // Remove old configuration (if there is any)
-    foreach (NetworkConnection *connection, m_networkSettings->connections()) {
-        if (connection->id() == connectionSettings.value("id")) {
-            connection->deleteConnection();
-        }
-    }
-
-    // Add connection
-    QDBusObjectPath connectionObjectPath = m_networkSettings->addConnection(settings);
-    if (connectionObjectPath.path().isEmpty())
-        return NetworkManagerErrorUnknownError;
-
-
-    qCDebug(dcNetworkManager()) << "Connection added" << connectionObjectPath.path();
-
-    // Activate connection
-    QDBusMessage query = m_networkManagerInterface->call("ActivateConnection",
-                                                         QVariant::fromValue(connectionObjectPath),
-                                                         QVariant::fromValue(networkDevice->objectPath()),
-                                                         QVariant::fromValue(QDBusObjectPath("/")));
-    if (query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcNetworkManager()) << query.errorName() << query.errorMessage();
-        return NetworkManagerErrorUnknownError;
-    }
-
-    return NetworkManagerErrorNoError;
-
+    return addAndActivateConnection(settings, networkDevice->objectPath(), NetworkManagerErrorUnknownError);
 }
 
 NetworkManager::NetworkManagerError NetworkManager::createSharedConnection(const QString &interface, const QHostAddress &ip, quint8 prefix)
+{
+    NetworkManagerReply *reply = createSharedConnectionAsync(interface, ip, prefix);
+    reply->waitForFinished();
+    return reply->error();
+}
+
+NetworkManagerReply *NetworkManager::createSharedConnectionAsync(const QString &interface, const QHostAddress &ip, quint8 prefix)
 {
     qCDebug(dcNetworkManager()) << "Starting shared connection for" << interface;
 
     NetworkDevice *networkDevice = getNetworkDevice(interface);
     if (!networkDevice) {
-        return NetworkManagerErrorNetworkInterfaceNotFound;
+        return createReply(NetworkManagerErrorNetworkInterfaceNotFound);
     }
 
     QVariantMap connectionSettings;
@@ -515,32 +483,7 @@ NetworkManager::NetworkManagerError NetworkManager::createSharedConnection(const
     settings.insert("ipv4", ipv4Settings);
     settings.insert("ipv6", ipv6Settings);
 
-    // Remove old configuration (if there is any)
-    foreach (NetworkConnection *connection, m_networkSettings->connections()) {
-        if (connection->id() == connectionSettings.value("id")) {
-            connection->deleteConnection();
-        }
-    }
-
-    // Add connection
-    QDBusObjectPath connectionObjectPath = m_networkSettings->addConnection(settings);
-    if (connectionObjectPath.path().isEmpty())
-        return NetworkManagerErrorUnknownError;
-
-
-    qCDebug(dcNetworkManager()) << "Connection added" << connectionObjectPath.path();
-
-    // Activate connection
-    QDBusMessage query = m_networkManagerInterface->call("ActivateConnection",
-                                                         QVariant::fromValue(connectionObjectPath),
-                                                         QVariant::fromValue(networkDevice->objectPath()),
-                                                         QVariant::fromValue(QDBusObjectPath("/")));
-    if (query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcNetworkManager()) << query.errorName() << query.errorMessage();
-        return NetworkManagerErrorUnknownError;
-    }
-
-    return NetworkManagerErrorNoError;
+    return addAndActivateConnection(settings, networkDevice->objectPath(), NetworkManagerErrorUnknownError);
 }
 
 /*! Returns true if the networking of this \l{NetworkManager} is enabled. */
@@ -587,25 +530,56 @@ bool NetworkManager::enableWireless(bool enabled)
     if (m_wirelessEnabled == enabled)
         return true;
 
-    return m_networkManagerInterface->setProperty("WirelessEnabled", enabled);
+    return m_networkManagerInterface->writeProperty("WirelessEnabled", enabled);
 }
 
 void NetworkManager::checkConnectivity()
 {
-    // Get network devices
-    qCDebug(dcNetworkManager()) << "Checking connectivity ...";
-    QDBusMessage query = m_networkManagerInterface->call("CheckConnectivity");
-    if(query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcNetworkManager()) << query.errorName() << query.errorMessage();
-        return;
+    checkConnectivityAsync()->waitForFinished();
+}
+
+/*! Returns the interval in milliseconds used by the \l{NetworkDevice}{network devices} to coalesce their change notifications. */
+int NetworkManager::deviceChangeInterval() const
+{
+    return m_deviceChangeInterval;
+}
+
+/*! Sets the interval in milliseconds used by all \l{NetworkDevice}{network devices} to coalesce their change notifications to \a deviceChangeInterval. 0 disables the coalescing. \sa NetworkDevice::setChangeNotificationInterval() */
+void NetworkManager::setDeviceChangeInterval(int deviceChangeInterval)
+{
+    m_deviceChangeInterval = qMax(0, deviceChangeInterval);
+    foreach (NetworkDevice *networkDevice, m_networkDevices) {
+        networkDevice->setChangeNotificationInterval(m_deviceChangeInterval);
     }
+}
 
-    if (query.arguments().isEmpty())
-        return;
+/*! Ask the NetworkManager to check the connectivity without blocking.
 
-    NetworkManagerConnectivityState state = static_cast<NetworkManagerConnectivityState>(query.arguments().at(0).toUInt());
-    qCDebug(dcNetworkManager()) << "Checked connectevitiy state successfully:" << query.arguments().at(0).toUInt() << state;
-    setConnectivityState(state);
+    The connectivity check might take a while since the NetworkManager performs a HTTP request. The \l{connectivityStateChanged()} signal
+    will be emitted once the state changed. The returned \l{NetworkManagerReply} finishes once the check has been performed.
+*/
+NetworkManagerReply *NetworkManager::checkConnectivityAsync()
+{
+    if (!m_networkManagerInterface)
+        return createReply(NetworkManagerErrorUnknownError);
+
+    qCDebug(dcNetworkManager()) << "Checking connectivity ...";
+    NetworkManagerReply *reply = new NetworkManagerReply(this);
+    QDBusPendingCallWatcher *watcher = reply->watch(m_networkManagerInterface->asyncCall("CheckConnectivity"));
+    connect(watcher, &QDBusPendingCallWatcher::finished, reply, [this, reply](QDBusPendingCallWatcher *call){
+        QDBusPendingReply<uint> connectivityReply = *call;
+        if (connectivityReply.isError()) {
+            qCWarning(dcNetworkManager()) << connectivityReply.error().name() << connectivityReply.error().message();
+            reply->finish(NetworkManagerErrorUnknownError);
+            return;
+        }
+
+        NetworkManagerConnectivityState state = static_cast<NetworkManagerConnectivityState>(connectivityReply.value());
+        qCDebug(dcNetworkManager()) << "Checked connectevitiy state successfully:" << connectivityReply.value() << state;
+        setConnectivityState(state);
+        reply->finish(NetworkManagerErrorNoError);
+    });
+    return reply;
 }
 
 void NetworkManager::init()
@@ -619,7 +593,7 @@ void NetworkManager::init()
     }
 
     // Create interface
-    m_networkManagerInterface = new QDBusInterface(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::networkManagerPathString(), NetworkManagerUtils::networkManagerServiceString(), QDBusConnection::systemBus(), this);
+    m_networkManagerInterface = new NetworkManagerDBusProxy(NetworkManagerUtils::networkManagerPathString(), NetworkManagerUtils::networkManagerServiceString(), QDBusConnection::systemBus(), this);
     if(!m_networkManagerInterface->isValid()) {
         qCWarning(dcNetworkManager()) << "Invalid DBus network manager interface. The NetworkManager is not available.";
         delete m_networkManagerInterface;
@@ -630,13 +604,26 @@ void NetworkManager::init()
 
     qCDebug(dcNetworkManager()) << "DBus interface created successfully" << NetworkManagerUtils::networkManagerPathString();
 
-    // Init properties
-    qCDebug(dcNetworkManager()) << "Reading initial properties...";
-    setVersion(m_networkManagerInterface->property("Version").toString());
-    setState(static_cast<NetworkManagerState>(m_networkManagerInterface->property("State").toUInt()));
-    setConnectivityState(static_cast<NetworkManagerConnectivityState>(m_networkManagerInterface->property("Connectivity").toUInt()));
-    setNetworkingEnabled(m_networkManagerInterface->property("NetworkingEnabled").toBool());
-    setWirelessEnabled(m_networkManagerInterface->property("WirelessEnabled").toBool());
+    // Init properties. Try to fetch the entire object tree in one round trip first (NetworkManager >= 1.6)
+    NMManagedObjects managedObjects;
+    bool managedObjectsLoaded = loadManagedObjects(managedObjects);
+    if (managedObjectsLoaded) {
+        qCDebug(dcNetworkManager()) << "Reading initial properties from" << managedObjects.count() << "managed objects...";
+        const QVariantMap properties = managedObjects.value(QDBusObjectPath(NetworkManagerUtils::networkManagerPathString())).value(NetworkManagerUtils::networkManagerServiceString());
+        setVersion(properties.value("Version").toString());
+        setState(static_cast<NetworkManagerState>(properties.value("State").toUInt()));
+        setConnectivityState(static_cast<NetworkManagerConnectivityState>(properties.value("Connectivity").toUInt()));
+        setNetworkingEnabled(properties.value("NetworkingEnabled").toBool());
+        setWirelessEnabled(properties.value("WirelessEnabled").toBool());
+    } else {
+        qCDebug(dcNetworkManager()) << "Reading initial properties...";
+        const QVariantMap properties = m_networkManagerInterface->readProperties();
+        setVersion(properties.value("Version").toString());
+        setState(static_cast<NetworkManagerState>(properties.value("State").toUInt()));
+        setConnectivityState(static_cast<NetworkManagerConnectivityState>(properties.value("Connectivity").toUInt()));
+        setNetworkingEnabled(properties.value("NetworkingEnabled").toBool());
+        setWirelessEnabled(properties.value("WirelessEnabled").toBool());
+    }
 
     if (m_version.isEmpty()) {
         qCWarning(dcNetworkManager()) << "Could not read initial properties. The NetworkManager might not be initialized yet. Reinitializing in 2 seconds...";
@@ -652,33 +639,39 @@ void NetworkManager::init()
     QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::networkManagerPathString(), NetworkManagerUtils::networkManagerServiceString(), "DeviceAdded", this, SLOT(onDeviceAdded(QDBusObjectPath)));
     QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::networkManagerPathString(), NetworkManagerUtils::networkManagerServiceString(), "DeviceRemoved", this, SLOT(onDeviceRemoved(QDBusObjectPath)));
 
-    // Networkmanager < 1.2.0 uses custom signal instead of the standard D-Bus properties changed signal
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::networkManagerPathString(), NetworkManagerUtils::networkManagerServiceString(), "PropertiesChanged", this, SLOT(processProperties(QVariantMap)));
-    // Networkmanager >= 1.2.0 uses standard D-Bus properties changed signal
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::networkManagerPathString(),  "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+    // Property changes of all objects (manager, devices, access points, settings) are dispatched from here
+    connectPropertiesChanged(true);
 
-    // Load network devices
-    loadDevices();
-
-    // Create settings
-    m_networkSettings = new NetworkSettings(this);
+    // Load network devices and create settings
+    if (managedObjectsLoaded) {
+        loadDevices(managedObjects);
+        m_networkSettings = new NetworkSettings(managedObjects, this);
+    } else {
+        loadDevices();
+        m_networkSettings = new NetworkSettings(this);
+    }
 
     setAvailable(true);
     qCDebug(dcNetworkManager()) << "NetworkManager initialized successfully.";
     qCDebug(dcNetworkManager()) << "Starting initial wireless network scan...";
     foreach (WirelessNetworkDevice *wirelessDevice, m_wirelessNetworkDevices.values()) {
-        wirelessDevice->scanWirelessNetworks();
+        wirelessDevice->requestScan();
     }
 }
 
 void NetworkManager::deinit()
 {
+    connectPropertiesChanged(false);
+
     foreach (NetworkDevice *device, m_networkDevices) {
         onDeviceRemoved(device->objectPath());
     }
 
     m_wiredNetworkDevices.clear();
     m_wirelessNetworkDevices.clear();
+    m_networkDevicesByInterface.clear();
+    m_networkDevicesByType.clear();
+    m_accessPoints.clear();
 
     if (m_networkSettings) {
         delete m_networkSettings;
@@ -690,6 +683,10 @@ void NetworkManager::deinit()
         m_networkManagerInterface  = nullptr;
     }
 
+    // The NetworkManager might get updated while not running
+    m_addAndActivateConnection2Available = true;
+    m_pendingPersistence.clear();
+
     setVersion(QString());
     setState(NetworkManagerStateUnknown);
     setConnectivityState(NetworkManagerConnectivityStateUnknown);
@@ -722,6 +719,452 @@ void NetworkManager::loadDevices()
     argument.endArray();
 }
 
+void NetworkManager::loadDevices(const NMManagedObjects &managedObjects)
+{
+    qCDebug(dcNetworkManager()) << "Load available devices from managed objects";
+    const QVariantMap properties = managedObjects.value(QDBusObjectPath(NetworkManagerUtils::networkManagerPathString())).value(NetworkManagerUtils::networkManagerServiceString());
+    const QDBusArgument argument = properties.value("Devices").value<QDBusArgument>();
+    argument.beginArray();
+    while(!argument.atEnd()) {
+        QDBusObjectPath deviceObjectPath = qdbus_cast<QDBusObjectPath>(argument);
+        if (m_networkDevices.contains(deviceObjectPath)) {
+            qCWarning(dcNetworkManager()) << "Device" << deviceObjectPath.path() << "already added.";
+            continue;
+        }
+
+        // The device might have shown up after the managed objects have been fetched
+        const QVariantMap deviceProperties = managedObjects.value(deviceObjectPath).value(NetworkManagerUtils::deviceInterfaceString());
+        if (deviceProperties.isEmpty()) {
+            onDeviceAdded(deviceObjectPath);
+            continue;
+        }
+
+        NetworkDevice::NetworkDeviceType deviceType = NetworkDevice::NetworkDeviceType(deviceProperties.value("DeviceType").toUInt());
+        switch (deviceType) {
+        case NetworkDevice::NetworkDeviceTypeWifi:
+            addWirelessNetworkDevice(new WirelessNetworkDevice(deviceObjectPath, managedObjects, this));
+            break;
+        case NetworkDevice::NetworkDeviceTypeEthernet:
+            addWiredNetworkDevice(new WiredNetworkDevice(deviceObjectPath, managedObjects, this));
+            break;
+        default:
+            addNetworkDevice(new NetworkDevice(deviceObjectPath, managedObjects, this));
+            break;
+        }
+    }
+    argument.endArray();
+}
+
+bool NetworkManager::loadManagedObjects(NMManagedObjects &managedObjects)
+{
+    QDBusMessage request = QDBusMessage::createMethodCall(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::objectManagerPathString(), NetworkManagerUtils::objectManagerInterfaceString(), "GetManagedObjects");
+    QDBusMessage reply = QDBusConnection::systemBus().call(request);
+    if (reply.type() != QDBusMessage::ReplyMessage || reply.arguments().isEmpty()) {
+        // Note: the ObjectManager interface is available since NetworkManager 1.6
+        qCDebug(dcNetworkManager()) << "Could not fetch managed objects. Falling back to reading properties one by one." << reply.errorName() << reply.errorMessage();
+        return false;
+    }
+
+    managedObjects = qdbus_cast<NMManagedObjects>(reply.arguments().at(0));
+    return managedObjects.value(QDBusObjectPath(NetworkManagerUtils::networkManagerPathString())).contains(NetworkManagerUtils::networkManagerServiceString());
+}
+
+void NetworkManager::addNetworkDevice(NetworkDevice *networkDevice)
+{
+    qCDebug(dcNetworkManager()) << "[+]" << networkDevice;
+    networkDevice->setChangeNotificationInterval(m_deviceChangeInterval);
+    m_networkDevices.insert(networkDevice->objectPath(), networkDevice);
+    indexNetworkDevice(networkDevice);
+}
+
+void NetworkManager::addWirelessNetworkDevice(WirelessNetworkDevice *wirelessNetworkDevice)
+{
+    qCDebug(dcNetworkManager()) << "[+]" << wirelessNetworkDevice;
+    wirelessNetworkDevice->setChangeNotificationInterval(m_deviceChangeInterval);
+    m_networkDevices.insert(wirelessNetworkDevice->objectPath(), wirelessNetworkDevice);
+    m_wirelessNetworkDevices.insert(wirelessNetworkDevice->objectPath(), wirelessNetworkDevice);
+    indexNetworkDevice(wirelessNetworkDevice);
+    connect(wirelessNetworkDevice, &WirelessNetworkDevice::deviceChanged, this, &NetworkManager::onWirelessDeviceChanged);
+
+    // Note: the access points from the managed objects have been loaded already
+    foreach (WirelessAccessPoint *accessPoint, wirelessNetworkDevice->accessPoints()) {
+        m_accessPoints.insert(accessPoint->objectPath(), accessPoint);
+    }
+    connect(wirelessNetworkDevice, &WirelessNetworkDevice::accessPointLoaded, this, [this](WirelessAccessPoint *accessPoint){
+        m_accessPoints.insert(accessPoint->objectPath(), accessPoint);
+    });
+    connect(wirelessNetworkDevice, &WirelessNetworkDevice::accessPointUnloaded, this, [this](WirelessAccessPoint *accessPoint){
+        if (m_accessPoints.value(accessPoint->objectPath()) == accessPoint)
+            m_accessPoints.remove(accessPoint->objectPath());
+    });
+    emit wirelessDeviceAdded(wirelessNetworkDevice);
+}
+
+void NetworkManager::addWiredNetworkDevice(WiredNetworkDevice *wiredNetworkDevice)
+{
+    qCDebug(dcNetworkManager()) << "[+]" << wiredNetworkDevice;
+    wiredNetworkDevice->setChangeNotificationInterval(m_deviceChangeInterval);
+    m_networkDevices.insert(wiredNetworkDevice->objectPath(), wiredNetworkDevice);
+    m_wiredNetworkDevices.insert(wiredNetworkDevice->objectPath(), wiredNetworkDevice);
+    indexNetworkDevice(wiredNetworkDevice);
+    connect(wiredNetworkDevice, &WiredNetworkDevice::deviceChanged, this, &NetworkManager::onWiredDeviceChanged);
+    emit wiredDeviceAdded(wiredNetworkDevice);
+}
+
+void NetworkManager::indexNetworkDevice(NetworkDevice *networkDevice)
+{
+    m_networkDevicesByInterface.insert(networkDevice->interface(), networkDevice);
+    m_networkDevicesByType[networkDevice->deviceType()].append(networkDevice);
+}
+
+void NetworkManager::unindexNetworkDevice(NetworkDevice *networkDevice)
+{
+    // Note: only drop the interface entry if it still belongs to this device
+    if (m_networkDevicesByInterface.value(networkDevice->interface()) == networkDevice)
+        m_networkDevicesByInterface.remove(networkDevice->interface());
+
+    QMap<NetworkDevice::NetworkDeviceType, QList<NetworkDevice *>>::iterator typeIterator = m_networkDevicesByType.find(networkDevice->deviceType());
+    if (typeIterator != m_networkDevicesByType.end()) {
+        typeIterator->removeAll(networkDevice);
+        if (typeIterator->isEmpty())
+            m_networkDevicesByType.erase(typeIterator);
+    }
+}
+
+NetworkManagerReply *NetworkManager::createReply(NetworkManagerError error)
+{
+    NetworkManagerReply *reply = new NetworkManagerReply(this);
+    reply->finish(error);
+    return reply;
+}
+
+NetworkManagerReply *NetworkManager::addAndActivateConnection(const ConnectionSettings &settings, const QDBusObjectPath &deviceObjectPath, NetworkManagerError failureError, ConnectionPersistence persistence)
+{
+    if (!m_networkSettings || !m_networkManagerInterface)
+        return createReply(NetworkManagerErrorUnknownError);
+
+    NetworkManagerReply *reply = new NetworkManagerReply(this);
+    reply->m_settings = settings;
+    reply->m_deviceObjectPath = deviceObjectPath;
+    reply->m_failureError = failureError;
+    reply->m_persistence = persistence;
+
+    if (!m_networkSettings->summariesPending()) {
+        findExistingConnections(reply);
+        return reply;
+    }
+
+    // Note: the existing profiles can only be looked up once their summaries arrived, don't block in the meantime
+    qCDebug(dcNetworkManager()) << "Waiting for the connection summaries before connecting";
+    reply->m_deferredStep = [this, reply](){
+        if (!m_networkSettings) {
+            processConnectionReply(reply);
+            return;
+        }
+
+        disconnect(m_networkSettings, nullptr, reply, nullptr);
+        findExistingConnections(reply);
+    };
+    connect(m_networkSettings, &NetworkSettings::summariesLoaded, reply, [this, reply](){
+        // Note: queued, a connection might have been added or updated in the meantime
+        if (!m_networkSettings || m_networkSettings->summariesPending())
+            return;
+
+        reply->runDeferredStep();
+    }, Qt::QueuedConnection);
+    connect(m_networkSettings, &QObject::destroyed, reply, [reply](){
+        qCWarning(dcNetworkManager()) << "NetworkManager not available any more. Cancel connection request.";
+        reply->m_deferredStep = nullptr;
+        reply->finish(NetworkManagerErrorUnknownError);
+    });
+    return reply;
+}
+
+void NetworkManager::findExistingConnections(NetworkManagerReply *reply)
+{
+    // Reuse the existing profile (if there is any) in order to keep its history and save writing a new one
+    NetworkConnection *existingConnection = m_networkSettings->findConnection(reply->m_settings);
+    if (existingConnection)
+        reply->m_existingConnection = existingConnection;
+
+    // Remove other configurations with the same id (if there are any)
+    foreach (NetworkConnection *connection, m_networkSettings->getConnections(reply->m_settings.value("connection").value("id").toString())) {
+        if (connection != existingConnection) {
+            reply->m_obsoleteConnections.append(connection);
+        }
+    }
+
+    processConnectionReply(reply);
+}
+
+void NetworkManager::processConnectionReply(NetworkManagerReply *reply)
+{
+    if (!m_networkSettings || !m_networkManagerInterface) {
+        qCWarning(dcNetworkManager()) << "NetworkManager not available any more. Cancel connection request.";
+        reply->finish(NetworkManagerErrorUnknownError);
+        return;
+    }
+
+    // Delete the obsolete connections. Note: there is no need to wait for them, the new connection gets a new uuid
+    while (!reply->m_obsoleteConnections.isEmpty()) {
+        QPointer<NetworkConnection> connection = reply->m_obsoleteConnections.takeFirst();
+        if (connection.isNull())
+            continue;
+
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(connection->deleteConnectionAsync(), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [](QDBusPendingCallWatcher *call){
+            call->deleteLater();
+            if (call->isError())
+                qCWarning(dcNetworkManager()) << call->error().name() << call->error().message();
+        });
+    }
+
+    if (!reply->m_existingConnection.isNull()) {
+        processExistingConnection(reply);
+        return;
+    }
+
+    // Add and activate the new connection within one call
+    QDBusPendingCall addAndActivateCall;
+    if (m_addAndActivateConnection2Available) {
+        // Note: available since NetworkManager 1.16
+        QVariantMap options;
+        switch (reply->m_persistence) {
+        case ConnectionPersistenceDisk:
+            options.insert("persist", "disk");
+            break;
+        case ConnectionPersistenceMemory:
+            options.insert("persist", "memory");
+            break;
+        case ConnectionPersistenceVolatile:
+            options.insert("persist", "volatile");
+            break;
+        }
+        addAndActivateCall = m_networkManagerInterface->asyncCall("AddAndActivateConnection2",
+                                                                  QVariant::fromValue(reply->m_settings),
+                                                                  QVariant::fromValue(reply->m_deviceObjectPath),
+                                                                  QVariant::fromValue(QDBusObjectPath("/")),
+                                                                  options);
+    } else {
+        if (reply->m_persistence != ConnectionPersistenceDisk)
+            qCDebug(dcNetworkManager()) << "In-memory connections are not supported by this NetworkManager. Writing the connection to disk.";
+
+        addAndActivateCall = m_networkManagerInterface->asyncCall("AddAndActivateConnection",
+                                                                  QVariant::fromValue(reply->m_settings),
+                                                                  QVariant::fromValue(reply->m_deviceObjectPath),
+                                                                  QVariant::fromValue(QDBusObjectPath("/")));
+    }
+
+    QDBusPendingCallWatcher *watcher = reply->watch(addAndActivateCall);
+    connect(watcher, &QDBusPendingCallWatcher::finished, reply, [this, reply](QDBusPendingCallWatcher *call){
+        processAddAndActivateReply(reply, call);
+    });
+}
+
+void NetworkManager::processAddAndActivateReply(NetworkManagerReply *reply, QDBusPendingCallWatcher *call)
+{
+    // Fall back to AddAndActivateConnection on NetworkManager versions older than 1.16
+    if (call->isError() && call->error().type() == QDBusError::UnknownMethod && m_addAndActivateConnection2Available) {
+        qCDebug(dcNetworkManager()) << "AddAndActivateConnection2 not available. Falling back to AddAndActivateConnection.";
+        m_addAndActivateConnection2Available = false;
+        processConnectionReply(reply);
+        return;
+    }
+
+    // Note: both methods return the connection settings path and the active connection path as first arguments
+    QDBusPendingReply<QDBusObjectPath, QDBusObjectPath> addAndActivateReply = *call;
+    if (addAndActivateReply.isError()) {
+        qCWarning(dcNetworkManager()) << addAndActivateReply.error().name() << addAndActivateReply.error().message();
+        reply->finish(reply->m_failureError);
+        return;
+    }
+
+    reply->m_connectionObjectPath = addAndActivateReply.argumentAt<0>();
+    reply->m_activeConnectionObjectPath = addAndActivateReply.argumentAt<1>();
+    qCDebug(dcNetworkManager()) << "Connection added" << reply->m_connectionObjectPath.path() << "and activated" << reply->m_activeConnectionObjectPath.path();
+    if (m_addAndActivateConnection2Available)
+        persistOnActivation(reply);
+
+    reply->finish(NetworkManagerErrorNoError);
+}
+
+void NetworkManager::processExistingConnection(NetworkManagerReply *reply)
+{
+    NetworkConnection *connection = reply->m_existingConnection.data();
+    if (!connection) {
+        qCDebug(dcNetworkManager()) << "Existing connection has been removed in the meantime. Adding a new one.";
+        processConnectionReply(reply);
+        return;
+    }
+
+    // Note: fetch the current settings, the profile might have been changed by someone else in the meantime
+    if (!reply->m_existingSettingsLoaded) {
+        QDBusPendingCallWatcher *watcher = reply->watch(connection->getSettingsAsync());
+        connect(watcher, &QDBusPendingCallWatcher::finished, reply, [this, reply](QDBusPendingCallWatcher *call){
+            QDBusPendingReply<ConnectionSettings> settingsReply = *call;
+            if (settingsReply.isError()) {
+                qCWarning(dcNetworkManager()) << "Could not load settings of existing connection:" << settingsReply.error().name() << settingsReply.error().message();
+                replaceExistingConnection(reply);
+                return;
+            }
+
+            reply->m_existingSettingsLoaded = true;
+            reply->m_existingSettings = settingsReply.value();
+            processExistingConnection(reply);
+        });
+        return;
+    }
+
+    // Note: secrets are not part of the connection settings, they have to be fetched in order to find out if they changed
+    if (reply->m_settings.contains("802-11-wireless-security") && !reply->m_secretsLoaded) {
+        QDBusPendingCallWatcher *watcher = reply->watch(connection->getSecretsAsync("802-11-wireless-security"));
+        connect(watcher, &QDBusPendingCallWatcher::finished, reply, [this, reply](QDBusPendingCallWatcher *call){
+            reply->m_secretsLoaded = true;
+            QDBusPendingReply<ConnectionSettings> secretsReply = *call;
+            if (secretsReply.isError()) {
+                // Note: the connection has no secrets stored, i.e. it was an open network before
+                qCDebug(dcNetworkManager()) << "Could not load secrets of existing connection:" << secretsReply.error().message();
+            } else {
+                reply->m_existingSettings = NetworkSettings::mergeSettings(reply->m_existingSettings, secretsReply.value());
+            }
+            processExistingConnection(reply);
+        });
+        return;
+    }
+
+    // Fast path: the profile is up to date and only needs to be activated
+    if (NetworkSettings::settingsApplied(reply->m_existingSettings, reply->m_settings)) {
+        qCDebug(dcNetworkManager()) << "Reusing unchanged connection" << connection;
+        activateExistingConnection(reply);
+        return;
+    }
+
+    // Note: in-memory updates keep the profile on disk untouched until the connection has been activated,
+    // volatile updates remove the profile from disk and drop it once the connection gets deactivated
+    NetworkConnection::UpdateFlags flags = NetworkConnection::UpdateFlagToDisk;
+    switch (reply->m_persistence) {
+    case ConnectionPersistenceDisk:
+        break;
+    case ConnectionPersistenceMemory:
+        flags = NetworkConnection::UpdateFlagInMemory;
+        break;
+    case ConnectionPersistenceVolatile:
+        flags = NetworkConnection::UpdateFlagInMemoryOnly | NetworkConnection::UpdateFlagVolatile;
+        break;
+    }
+
+    qCDebug(dcNetworkManager()) << "Updating existing connection" << connection << reply->m_persistence;
+    ConnectionSettings settings = NetworkSettings::mergeSettings(reply->m_existingSettings, reply->m_settings);
+    QDBusPendingCallWatcher *watcher = reply->watch(connection->updateAsync(settings, flags));
+    connect(watcher, &QDBusPendingCallWatcher::finished, reply, [this, reply](QDBusPendingCallWatcher *call){
+        if (call->isError()) {
+            // Note: Update2 is available since NetworkManager 1.12
+            qCWarning(dcNetworkManager()) << "Could not update existing connection:" << call->error().name() << call->error().message();
+            replaceExistingConnection(reply);
+            return;
+        }
+        reply->m_updated = true;
+        activateExistingConnection(reply);
+    });
+}
+
+void NetworkManager::activateExistingConnection(NetworkManagerReply *reply)
+{
+    if (reply->m_existingConnection.isNull() || !m_networkManagerInterface) {
+        processConnectionReply(reply);
+        return;
+    }
+
+    QDBusObjectPath connectionObjectPath = reply->m_existingConnection->objectPath();
+    QDBusPendingCall activateCall = m_networkManagerInterface->asyncCall("ActivateConnection",
+                                                                         QVariant::fromValue(connectionObjectPath),
+                                                                         QVariant::fromValue(reply->m_deviceObjectPath),
+                                                                         QVariant::fromValue(QDBusObjectPath("/")));
+    QDBusPendingCallWatcher *watcher = reply->watch(activateCall);
+    connect(watcher, &QDBusPendingCallWatcher::finished, reply, [this, reply, connectionObjectPath](QDBusPendingCallWatcher *call){
+        QDBusPendingReply<QDBusObjectPath> activateReply = *call;
+        if (activateReply.isError()) {
+            qCWarning(dcNetworkManager()) << activateReply.error().name() << activateReply.error().message();
+            reply->finish(reply->m_failureError);
+            return;
+        }
+
+        reply->m_connectionObjectPath = connectionObjectPath;
+        reply->m_activeConnectionObjectPath = activateReply.value();
+        qCDebug(dcNetworkManager()) << "Connection" << connectionObjectPath.path() << "activated" << reply->m_activeConnectionObjectPath.path();
+        if (reply->m_updated)
+            persistOnActivation(reply);
+
+        reply->finish(NetworkManagerErrorNoError);
+    });
+}
+
+void NetworkManager::replaceExistingConnection(NetworkManagerReply *reply)
+{
+    // Fall back to delete the existing connection and add a new one
+    if (!reply->m_existingConnection.isNull())
+        reply->m_obsoleteConnections.append(reply->m_existingConnection);
+
+    reply->m_existingConnection.clear();
+    processConnectionReply(reply);
+}
+
+void NetworkManager::persistOnActivation(NetworkManagerReply *reply)
+{
+    // Note: volatile connections will never be written to disk
+    if (reply->m_persistence != ConnectionPersistenceMemory)
+        return;
+
+    // Note: the State of the active connection gets dispatched with the PropertiesChanged signals
+    const QDBusObjectPath activeConnectionObjectPath = reply->m_activeConnectionObjectPath;
+    m_pendingPersistence.insert(activeConnectionObjectPath, reply->m_connectionObjectPath);
+
+    // The connection might have been activated before the first change arrives
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(NetworkManagerDBusProxy::readObjectPropertiesAsync(activeConnectionObjectPath.path(), NetworkManagerUtils::activeConnectionInterfaceString()), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, activeConnectionObjectPath](QDBusPendingCallWatcher *call){
+        call->deleteLater();
+        QDBusPendingReply<QVariantMap> reply = *call;
+        if (reply.isError()) {
+            // Note: the active connection is gone already, i.e. the activation failed
+            processActiveConnectionState(activeConnectionObjectPath, 4);
+            return;
+        }
+
+        processActiveConnectionState(activeConnectionObjectPath, reply.value().value("State").toUInt());
+    });
+}
+
+void NetworkManager::processActiveConnectionState(const QDBusObjectPath &activeConnectionObjectPath, uint state)
+{
+    if (!m_pendingPersistence.contains(activeConnectionObjectPath))
+        return;
+
+    // Note: NMActiveConnectionState, 2 = activated, 4 = deactivated
+    if (state == 4) {
+        qCDebug(dcNetworkManager()) << "In-memory connection" << m_pendingPersistence.take(activeConnectionObjectPath).path() << "did not get activated. Not writing it to disk.";
+        return;
+    }
+
+    if (state != 2)
+        return;
+
+    const QDBusObjectPath connectionObjectPath = m_pendingPersistence.take(activeConnectionObjectPath);
+    NetworkConnection *connection = m_networkSettings ? m_networkSettings->getConnection(connectionObjectPath) : nullptr;
+    if (!connection) {
+        qCWarning(dcNetworkManager()) << "Could not find activated in-memory connection" << connectionObjectPath.path();
+        return;
+    }
+
+    // Note: updating with empty settings only applies the flags
+    qCDebug(dcNetworkManager()) << "Connection activated. Writing" << connection << "to disk.";
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(connection->updateAsync(ConnectionSettings(), NetworkConnection::UpdateFlagToDisk), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [](QDBusPendingCallWatcher *call){
+        call->deleteLater();
+        if (call->isError())
+            qCWarning(dcNetworkManager()) << "Could not write connection to disk:" << call->error().name() << call->error().message();
+    });
+}
+
 QString NetworkManager::networkManagerStateToString(const NetworkManager::NetworkManagerState &state)
 {
     QMetaObject metaObject = NetworkManager::staticMetaObject;
@@ -786,7 +1229,7 @@ void NetworkManager::setState(const NetworkManager::NetworkManagerState &state)
     qCDebug(dcNetworkManager()) << "State changed:" << networkManagerStateToString(state);
     m_state = state;
     emit stateChanged(m_state);
-    checkConnectivity();
+    checkConnectivityAsync();
 }
 
 void NetworkManager::onServiceRegistered()
@@ -808,56 +1251,43 @@ void NetworkManager::onStateChanged(uint state)
 
 void NetworkManager::onDeviceAdded(const QDBusObjectPath &deviceObjectPath)
 {
-    if (m_networkDevices.keys().contains(deviceObjectPath)) {
+    if (m_networkDevices.contains(deviceObjectPath)) {
         qCWarning(dcNetworkManager()) << "Device" << deviceObjectPath.path() << "already added.";
         return;
     }
 
     // Get device Type
-    QDBusInterface networkDeviceInterface(NetworkManagerUtils::networkManagerServiceString(), deviceObjectPath.path(), NetworkManagerUtils::deviceInterfaceString(), QDBusConnection::systemBus());
-    if(!networkDeviceInterface.isValid()) {
+    NetworkManagerDBusProxy networkDeviceInterface(deviceObjectPath.path(), NetworkManagerUtils::deviceInterfaceString());
+    QVariant deviceTypeValue = networkDeviceInterface.readProperty("DeviceType");
+    if(!deviceTypeValue.isValid()) {
         qCWarning(dcNetworkManager()) << "NetworkDevice: Invalid DBus device interface" << deviceObjectPath.path();
         return;
     }
 
     // Create object
-    NetworkDevice::NetworkDeviceType deviceType = NetworkDevice::NetworkDeviceType(networkDeviceInterface.property("DeviceType").toUInt());
+    NetworkDevice::NetworkDeviceType deviceType = NetworkDevice::NetworkDeviceType(deviceTypeValue.toUInt());
     switch (deviceType) {
-    case NetworkDevice::NetworkDeviceTypeWifi: {
-        WirelessNetworkDevice *wirelessNetworkDevice = new WirelessNetworkDevice(deviceObjectPath, this);
-        qCDebug(dcNetworkManager()) << "[+]" << wirelessNetworkDevice;
-        m_networkDevices.insert(deviceObjectPath, wirelessNetworkDevice);
-        m_wirelessNetworkDevices.insert(deviceObjectPath, wirelessNetworkDevice);
-        connect(wirelessNetworkDevice, &WirelessNetworkDevice::deviceChanged, this, &NetworkManager::onWirelessDeviceChanged);
-        emit wirelessDeviceAdded(wirelessNetworkDevice);
+    case NetworkDevice::NetworkDeviceTypeWifi:
+        addWirelessNetworkDevice(new WirelessNetworkDevice(deviceObjectPath, this));
         break;
-    }
-    case NetworkDevice::NetworkDeviceTypeEthernet: {
-        WiredNetworkDevice *wiredNetworkDevice = new WiredNetworkDevice(deviceObjectPath, this);
-        qCDebug(dcNetworkManager()) << "[+]" << wiredNetworkDevice;
-        m_networkDevices.insert(deviceObjectPath, wiredNetworkDevice);
-        m_wiredNetworkDevices.insert(deviceObjectPath, wiredNetworkDevice);
-
-        connect(wiredNetworkDevice, &WiredNetworkDevice::deviceChanged, this, &NetworkManager::onWiredDeviceChanged);
-        emit wiredDeviceAdded(wiredNetworkDevice);
+    case NetworkDevice::NetworkDeviceTypeEthernet:
+        addWiredNetworkDevice(new WiredNetworkDevice(deviceObjectPath, this));
         break;
-    }
     default:
-        NetworkDevice *networkDevice = new NetworkDevice(deviceObjectPath, this);
-        qCDebug(dcNetworkManager()) << "[+]" << networkDevice;
-        m_networkDevices.insert(deviceObjectPath, networkDevice);
+        addNetworkDevice(new NetworkDevice(deviceObjectPath, this));
         break;
     }
 }
 
 void NetworkManager::onDeviceRemoved(const QDBusObjectPath &deviceObjectPath)
 {
-    if (!m_networkDevices.keys().contains(deviceObjectPath)) {
+    if (!m_networkDevices.contains(deviceObjectPath)) {
         qCWarning(dcNetworkManager()) << "Unknown network device removed:" << deviceObjectPath.path();
         return;
     }
 
     NetworkDevice *networkDevice = m_networkDevices.take(deviceObjectPath);
+    unindexNetworkDevice(networkDevice);
 
     if (m_wiredNetworkDevices.contains(deviceObjectPath)) {
         qCDebug(dcNetworkManager()) << "[-]" << m_wiredNetworkDevices.value(deviceObjectPath);
@@ -865,7 +1295,14 @@ void NetworkManager::onDeviceRemoved(const QDBusObjectPath &deviceObjectPath)
         emit wiredDeviceRemoved(networkDevice->interface());
     } else if (m_wirelessNetworkDevices.contains(deviceObjectPath)) {
         qCDebug(dcNetworkManager()) << "[-]" << m_wirelessNetworkDevices.value(deviceObjectPath);
-        m_wirelessNetworkDevices.remove(deviceObjectPath);
+        WirelessNetworkDevice *wirelessNetworkDevice = m_wirelessNetworkDevices.take(deviceObjectPath);
+        disconnect(wirelessNetworkDevice, &WirelessNetworkDevice::accessPointLoaded, this, nullptr);
+        disconnect(wirelessNetworkDevice, &WirelessNetworkDevice::accessPointUnloaded, this, nullptr);
+        foreach (WirelessAccessPoint *accessPoint, wirelessNetworkDevice->accessPoints()) {
+            if (m_accessPoints.value(accessPoint->objectPath()) == accessPoint)
+                m_accessPoints.remove(accessPoint->objectPath());
+        }
+
         if (!wirelessAvailable())
             emit wirelessAvailableChanged(wirelessAvailable());
 
@@ -877,12 +1314,96 @@ void NetworkManager::onDeviceRemoved(const QDBusObjectPath &deviceObjectPath)
     networkDevice->deleteLater();
 }
 
-void NetworkManager::onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties)
+void NetworkManager::onPropertiesChanged(const QDBusMessage &message)
+{
+    // org.freedesktop.DBus.Properties.PropertiesChanged(s interface, a{sv} changedProperties, as invalidatedProperties)
+    if (message.arguments().count() < 2)
+        return;
+
+    //qCDebug(dcNetworkManager()) << "NetworkManager: Properties changed" << message.path() << message.arguments();
+    dispatchPropertiesChanged(message.path(), message.arguments().at(0).toString(), qdbus_cast<QVariantMap>(message.arguments().at(1)));
+}
+
+void NetworkManager::onLegacyPropertiesChanged(const QDBusMessage &message)
+{
+    // <interface>.PropertiesChanged(a{sv} properties)
+    if (message.arguments().isEmpty())
+        return;
+
+    dispatchPropertiesChanged(message.path(), message.interface(), qdbus_cast<QVariantMap>(message.arguments().at(0)));
+}
+
+void NetworkManager::connectPropertiesChanged(bool enabled)
+{
+    QDBusConnection systemBus = QDBusConnection::systemBus();
+    // Networkmanager >= 1.2.0 uses standard D-Bus properties changed signal. One subscription for all objects of the NetworkManager service.
+    if (enabled) {
+        systemBus.connect(NetworkManagerUtils::networkManagerServiceString(), QString(), "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QDBusMessage)));
+    } else {
+        systemBus.disconnect(NetworkManagerUtils::networkManagerServiceString(), QString(), "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QDBusMessage)));
+    }
+
+    // Networkmanager < 1.2.0 uses custom signals instead of the standard D-Bus properties changed signal, one per interface
+    QStringList legacyInterfaces;
+    legacyInterfaces << NetworkManagerUtils::networkManagerServiceString();
+    legacyInterfaces << NetworkManagerUtils::wirelessInterfaceString();
+    legacyInterfaces << NetworkManagerUtils::wiredInterfaceString();
+    legacyInterfaces << NetworkManagerUtils::accessPointInterfaceString();
+    legacyInterfaces << NetworkManagerUtils::settingsInterfaceString();
+    foreach (const QString &interface, legacyInterfaces) {
+        if (enabled) {
+            systemBus.connect(NetworkManagerUtils::networkManagerServiceString(), QString(), interface, "PropertiesChanged", this, SLOT(onLegacyPropertiesChanged(QDBusMessage)));
+        } else {
+            systemBus.disconnect(NetworkManagerUtils::networkManagerServiceString(), QString(), interface, "PropertiesChanged", this, SLOT(onLegacyPropertiesChanged(QDBusMessage)));
+        }
+    }
+}
+
+void NetworkManager::dispatchPropertiesChanged(const QString &path, const QString &interface, const QVariantMap &properties)
 {
-    Q_UNUSED(interface)
-    Q_UNUSED(invalidatedProperties)
-    //qCDebug(dcNetworkManager()) << "NetworkManager: Properties changed" << interface << changedProperties << invalidatedProperties;
-    processProperties(changedProperties);
+    const QDBusObjectPath objectPath(path);
+
+    if (interface == NetworkManagerUtils::accessPointInterfaceString()) {
+        WirelessAccessPoint *accessPoint = m_accessPoints.value(objectPath);
+        if (accessPoint)
+            accessPoint->processProperties(properties);
+
+        return;
+    }
+
+    if (interface == NetworkManagerUtils::wirelessInterfaceString()) {
+        WirelessNetworkDevice *wirelessNetworkDevice = m_wirelessNetworkDevices.value(objectPath);
+        if (wirelessNetworkDevice)
+            wirelessNetworkDevice->processProperties(properties);
+
+        return;
+    }
+
+    if (interface == NetworkManagerUtils::wiredInterfaceString()) {
+        WiredNetworkDevice *wiredNetworkDevice = m_wiredNetworkDevices.value(objectPath);
+        if (wiredNetworkDevice)
+            wiredNetworkDevice->processProperties(properties);
+
+        return;
+    }
+
+    if (interface == NetworkManagerUtils::activeConnectionInterfaceString()) {
+        if (properties.contains("State"))
+            processActiveConnectionState(objectPath, properties.value("State").toUInt());
+
+        return;
+    }
+
+    if (interface == NetworkManagerUtils::settingsInterfaceString()) {
+        if (m_networkSettings && path == NetworkManagerUtils::settingsPathString())
+            m_networkSettings->processProperties(properties);
+
+        return;
+    }
+
+    if (interface == NetworkManagerUtils::networkManagerServiceString() && path == NetworkManagerUtils::networkManagerPathString()) {
+        processProperties(properties);
+    }
 }
 
 void NetworkManager::processProperties(const QVariantMap &properties)
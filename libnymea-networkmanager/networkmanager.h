@@ -37,8 +37,11 @@
 #include "networksettings.h"
 #include "wirednetworkdevice.h"
 #include "networkmanagerutils.h"
+#include "networkmanagerdbusproxy.h"
 #include "wirelessnetworkdevice.h"
 
+class NetworkManagerReply;
+
 // Docs: https://developer.gnome.org/NetworkManager/unstable/spec.html
 
 class NetworkManager : public QObject
@@ -96,6 +99,13 @@ public:
     };
     Q_ENUM(KeyManagement)
 
+    enum ConnectionPersistence {
+        ConnectionPersistenceDisk,
+        ConnectionPersistenceMemory,
+        ConnectionPersistenceVolatile
+    };
+    Q_ENUM(ConnectionPersistence)
+
     explicit NetworkManager(QObject *parent = nullptr);
     ~NetworkManager();
 
@@ -105,9 +115,12 @@ public:
     QList<NetworkDevice *> networkDevices() const;
     QList<WirelessNetworkDevice *> wirelessNetworkDevices() const;
     QList<WiredNetworkDevice *> wiredNetworkDevices() const;
+    QList<NetworkDevice *> networkDevices(NetworkDevice::NetworkDeviceType deviceType) const;
 
     NetworkSettings *networkSettings() const;
     NetworkDevice *getNetworkDevice(const QString &interface);
+    WirelessNetworkDevice *getWirelessNetworkDevice(const QString &interface) const;
+    WiredNetworkDevice *getWiredNetworkDevice(const QString &interface) const;
 
     // Properties
     QString version() const;
@@ -115,12 +128,18 @@ public:
     QString stateString() const;
     NetworkManagerConnectivityState connectivityState() const;
 
-    NetworkManagerError connectWifi(const QString &interface, const QString &ssid, const QString &password, AuthAlgorithm authAlgorithm = AuthAlgorithmOpen, KeyManagement keyManagement = KeyManagementWpaPsk, bool hidden = false);
-    NetworkManagerError startAccessPoint(const QString &interface, const QString &ssid, const QString &password);
+    NetworkManagerError connectWifi(const QString &interface, const QString &ssid, const QString &password, AuthAlgorithm authAlgorithm = AuthAlgorithmOpen, KeyManagement keyManagement = KeyManagementWpaPsk, bool hidden = false, ConnectionPersistence persistence = ConnectionPersistenceDisk);
+    NetworkManagerError startAccessPoint(const QString &interface, const QString &ssid, const QString &password, ConnectionPersistence persistence = ConnectionPersistenceDisk);
     NetworkManagerError createWiredAutoConnection(const QString &interface);
     NetworkManagerError createWiredManualConnection(const QString &interface, const QHostAddress &ip, quint8 prefix, const QHostAddress &gateway, const QHostAddress &dns);
     NetworkManagerError createSharedConnection(const QString& interface, const QHostAddress &ip, quint8 prefix);
 
+    NetworkManagerReply *connectWifiAsync(const QString &interface, const QString &ssid, const QString &password, AuthAlgorithm authAlgorithm = AuthAlgorithmOpen, KeyManagement keyManagement = KeyManagementWpaPsk, bool hidden = false, ConnectionPersistence persistence = ConnectionPersistenceDisk);
+    NetworkManagerReply *startAccessPointAsync(const QString &interface, const QString &ssid, const QString &password, ConnectionPersistence persistence = ConnectionPersistenceDisk);
+    NetworkManagerReply *createWiredAutoConnectionAsync(const QString &interface);
+    NetworkManagerReply *createWiredManualConnectionAsync(const QString &interface, const QHostAddress &ip, quint8 prefix, const QHostAddress &gateway, const QHostAddress &dns);
+    NetworkManagerReply *createSharedConnectionAsync(const QString& interface, const QHostAddress &ip, quint8 prefix);
+
     // Networking
     bool networkingEnabled() const;
     bool enableNetworking(bool enabled);
@@ -130,17 +149,33 @@ public:
     bool enableWireless(bool enabled);
 
     void checkConnectivity();
+    NetworkManagerReply *checkConnectivityAsync();
+
+    int deviceChangeInterval() const;
+    void setDeviceChangeInterval(int deviceChangeInterval);
 
 private:
     QDBusServiceWatcher *m_serviceWatcher = nullptr;
-    QDBusInterface *m_networkManagerInterface  = nullptr;
+    NetworkManagerDBusProxy *m_networkManagerInterface  = nullptr;
     NetworkSettings *m_networkSettings  = nullptr;
 
     QHash<QDBusObjectPath, NetworkDevice *> m_networkDevices;
     QHash<QDBusObjectPath, WirelessNetworkDevice *> m_wirelessNetworkDevices;
     QHash<QDBusObjectPath, WiredNetworkDevice *> m_wiredNetworkDevices;
 
+    // Secondary indexes, maintained together with m_networkDevices
+    QHash<QString, NetworkDevice *> m_networkDevicesByInterface;
+    QMap<NetworkDevice::NetworkDeviceType, QList<NetworkDevice *>> m_networkDevicesByType;
+
+    // Access points of all wireless devices, for dispatching their property changes
+    QHash<QDBusObjectPath, WirelessAccessPoint *> m_accessPoints;
+
     bool m_available = false;
+    int m_deviceChangeInterval = 250;
+    bool m_addAndActivateConnection2Available = true;
+
+    // In-memory connections which get written to disk once activated, connection object path by active connection object path
+    QHash<QDBusObjectPath, QDBusObjectPath> m_pendingPersistence;
 
     QString m_version;
     NetworkManagerState m_state = NetworkManagerStateUnknown;
@@ -152,6 +187,28 @@ private:
     void deinit();
 
     void loadDevices();
+    void loadDevices(const NMManagedObjects &managedObjects);
+    bool loadManagedObjects(NMManagedObjects &managedObjects);
+
+    void connectPropertiesChanged(bool enabled);
+    void dispatchPropertiesChanged(const QString &path, const QString &interface, const QVariantMap &properties);
+
+    NetworkManagerReply *createReply(NetworkManagerError error);
+    NetworkManagerReply *addAndActivateConnection(const ConnectionSettings &settings, const QDBusObjectPath &deviceObjectPath, NetworkManagerError failureError, ConnectionPersistence persistence = ConnectionPersistenceDisk);
+    void findExistingConnections(NetworkManagerReply *reply);
+    void processConnectionReply(NetworkManagerReply *reply);
+    void processAddAndActivateReply(NetworkManagerReply *reply, QDBusPendingCallWatcher *call);
+    void processExistingConnection(NetworkManagerReply *reply);
+    void activateExistingConnection(NetworkManagerReply *reply);
+    void replaceExistingConnection(NetworkManagerReply *reply);
+    void persistOnActivation(NetworkManagerReply *reply);
+    void processActiveConnectionState(const QDBusObjectPath &activeConnectionObjectPath, uint state);
+
+    void addNetworkDevice(NetworkDevice *networkDevice);
+    void addWirelessNetworkDevice(WirelessNetworkDevice *wirelessNetworkDevice);
+    void addWiredNetworkDevice(WiredNetworkDevice *wiredNetworkDevice);
+    void indexNetworkDevice(NetworkDevice *networkDevice);
+    void unindexNetworkDevice(NetworkDevice *networkDevice);
 
     static QString networkManagerStateToString(const NetworkManagerState &state);
     static QString networkManagerConnectivityStateToString(const NetworkManagerConnectivityState &state);
@@ -187,7 +244,8 @@ private slots:
     void onStateChanged(uint state);
     void onDeviceAdded(const QDBusObjectPath &deviceObjectPath);
     void onDeviceRemoved(const QDBusObjectPath &deviceObjectPath);
-    void onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties);
+    void onPropertiesChanged(const QDBusMessage &message);
+    void onLegacyPropertiesChanged(const QDBusMessage &message);
     void processProperties(const QVariantMap &properties);
 
     void onWirelessDeviceChanged();
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*!
+    \class NetworkManagerDBusProxy
+    \brief Lightweight proxy for a NetworkManager dbus object.
+    \inmodule nymea-networkmanager
+    \ingroup networkmanager
+
+    In contrast to QDBusInterface this proxy does not introspect the remote object on construction.
+    Methods are called using the inherited call() and asyncCall() methods, properties are accessed
+    explicitly using the org.freedesktop.DBus.Properties interface.
+
+*/
+
+#include "networkmanagerdbusproxy.h"
+#include "networkmanagerutils.h"
+
+#include <QDBusMessage>
+
+/*! Constructs a new \l{NetworkManagerDBusProxy} for the given \a interface on the NetworkManager object \a path using the given \a connection and \a parent. */
+NetworkManagerDBusProxy::NetworkManagerDBusProxy(const QString &path, const QString &interface, const QDBusConnection &connection, QObject *parent) :
+    QDBusAbstractInterface(NetworkManagerUtils::networkManagerServiceString(), path, interface.toUtf8().constData(), connection, parent)
+{
+
+}
+
+/*! Reads the property with the given \a name. Returns an invalid QVariant if the property could not be read. */
+QVariant NetworkManagerDBusProxy::readProperty(const QString &name)
+{
+    QDBusPendingReply<QDBusVariant> reply = readPropertyAsync(name);
+    reply.waitForFinished();
+    if (reply.isError()) {
+        qCWarning(dcNetworkManager()) << "Could not read property" << name << "of" << path() << reply.error().name() << reply.error().message();
+        return QVariant();
+    }
+
+    return reply.value().variant();
+}
+
+/*! Reads the property with the given \a name without blocking. */
+QDBusPendingReply<QDBusVariant> NetworkManagerDBusProxy::readPropertyAsync(const QString &name)
+{
+    QDBusMessage message = createPropertiesCall("Get");
+    message << interface() << name;
+    return connection().asyncCall(message);
+}
+
+/*! Reads all properties of this object with one call. Returns an empty map if the properties could not be read. */
+QVariantMap NetworkManagerDBusProxy::readProperties()
+{
+    QDBusPendingReply<QVariantMap> reply = readPropertiesAsync();
+    reply.waitForFinished();
+    if (reply.isError()) {
+        qCWarning(dcNetworkManager()) << "Could not read properties of" << path() << reply.error().name() << reply.error().message();
+        return QVariantMap();
+    }
+
+    return reply.value();
+}
+
+/*! Reads all properties of this object with one call without blocking. */
+QDBusPendingReply<QVariantMap> NetworkManagerDBusProxy::readPropertiesAsync()
+{
+    return readObjectPropertiesAsync(path(), interface(), connection());
+}
+
+/*! Writes the given \a value to the property with the given \a name. Returns true if the property has been written successfully. */
+bool NetworkManagerDBusProxy::writeProperty(const QString &name, const QVariant &value)
+{
+    QDBusMessage message = createPropertiesCall("Set");
+    message << interface() << name << QVariant::fromValue(QDBusVariant(value));
+    QDBusMessage reply = connection().call(message);
+    if (reply.type() != QDBusMessage::ReplyMessage) {
+        qCWarning(dcNetworkManager()) << "Could not write property" << name << "of" << path() << reply.errorName() << reply.errorMessage();
+        return false;
+    }
+
+    return true;
+}
+
+/*! Reads all properties of the given \a interface on the NetworkManager object \a path using the given \a connection without creating a proxy object.
+
+    This is useful for objects which get read only once, like access points.
+*/
+QDBusPendingReply<QVariantMap> NetworkManagerDBusProxy::readObjectPropertiesAsync(const QString &path, const QString &interface, const QDBusConnection &connection)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(NetworkManagerUtils::networkManagerServiceString(), path, "org.freedesktop.DBus.Properties", "GetAll");
+    message << interface;
+    return connection.asyncCall(message);
+}
+
+QDBusMessage NetworkManagerDBusProxy::createPropertiesCall(const QString &method) const
+{
+    return QDBusMessage::createMethodCall(service(), path(), "org.freedesktop.DBus.Properties", method);
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef NETWORKMANAGERDBUSPROXY_H
+#define NETWORKMANAGERDBUSPROXY_H
+
+#include <QObject>
+#include <QVariant>
+#include <QVariantMap>
+#include <QDBusVariant>
+#include <QDBusConnection>
+#include <QDBusPendingReply>
+#include <QDBusAbstractInterface>
+
+class NetworkManagerDBusProxy : public QDBusAbstractInterface
+{
+    Q_OBJECT
+public:
+    explicit NetworkManagerDBusProxy(const QString &path, const QString &interface, const QDBusConnection &connection = QDBusConnection::systemBus(), QObject *parent = nullptr);
+
+    QVariant readProperty(const QString &name);
+    QDBusPendingReply<QDBusVariant> readPropertyAsync(const QString &name);
+
+    QVariantMap readProperties();
+    QDBusPendingReply<QVariantMap> readPropertiesAsync();
+
+    bool writeProperty(const QString &name, const QVariant &value);
+
+    static QDBusPendingReply<QVariantMap> readObjectPropertiesAsync(const QString &path, const QString &interface, const QDBusConnection &connection = QDBusConnection::systemBus());
+
+private:
+    QDBusMessage createPropertiesCall(const QString &method) const;
+
+};
+
+#endif // NETWORKMANAGERDBUSPROXY_H
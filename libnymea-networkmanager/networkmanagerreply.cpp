@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*!
+    \class NetworkManagerReply
+    \brief Represents the result of an asynchronous \l{NetworkManager} request.
+    \inmodule nymea-networkmanager
+    \ingroup networkmanager
+
+    A reply is returned by the asynchronous methods of the \l{NetworkManager} and finishes once
+    all involved dbus calls have been answered by the NetworkManager. The reply deletes itself
+    after the \l{finished()} signal has been emitted.
+
+*/
+
+/*! \fn void NetworkManagerReply::finished();
+    This signal will be emitted once the request of this \l{NetworkManagerReply} has been processed.
+
+    \sa error()
+*/
+
+#include "networkmanagerreply.h"
+
+NetworkManagerReply::NetworkManagerReply(QObject *parent) :
+    QObject(parent)
+{
+    connect(this, &NetworkManagerReply::finished, this, &NetworkManagerReply::deleteLater, Qt::QueuedConnection);
+}
+
+/*! Returns true if the request of this \l{NetworkManagerReply} has been processed. */
+bool NetworkManagerReply::isFinished() const
+{
+    return m_finished;
+}
+
+/*! Returns the result of this \l{NetworkManagerReply}. Only valid once the reply is finished. */
+NetworkManager::NetworkManagerError NetworkManagerReply::error() const
+{
+    return m_error;
+}
+
+/*! Returns the dbus object path of the connection settings created by this request, if any. */
+QDBusObjectPath NetworkManagerReply::connectionObjectPath() const
+{
+    return m_connectionObjectPath;
+}
+
+/*! Returns the dbus object path of the active connection created by this request, if any. */
+QDBusObjectPath NetworkManagerReply::activeConnectionObjectPath() const
+{
+    return m_activeConnectionObjectPath;
+}
+
+/*! Blocks until this \l{NetworkManagerReply} is finished.
+
+    This is used by the synchronous methods of the \l{NetworkManager} and should be avoided within the event loop thread of a daemon.
+*/
+void NetworkManagerReply::waitForFinished()
+{
+    // Each processed step might start the next call and replace the current watcher
+    while (!m_finished) {
+        if (m_deferredStep) {
+            runDeferredStep();
+        } else if (m_watcher) {
+            m_watcher->waitForFinished();
+        } else {
+            break;
+        }
+    }
+}
+
+QDBusPendingCallWatcher *NetworkManagerReply::watch(const QDBusPendingCall &pendingCall)
+{
+    m_watcher = new QDBusPendingCallWatcher(pendingCall, this);
+    connect(m_watcher.data(), &QDBusPendingCallWatcher::finished, m_watcher.data(), &QDBusPendingCallWatcher::deleteLater);
+    return m_watcher.data();
+}
+
+void NetworkManagerReply::runDeferredStep()
+{
+    // Note: the step might defer again
+    std::function<void()> step = m_deferredStep;
+    m_deferredStep = nullptr;
+    if (step)
+        step();
+}
+
+void NetworkManagerReply::finish(NetworkManager::NetworkManagerError error)
+{
+    m_error = error;
+    m_finished = true;
+    m_watcher.clear();
+    m_deferredStep = nullptr;
+
+    // Make sure the caller had the chance to connect to the finished signal
+    QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+}
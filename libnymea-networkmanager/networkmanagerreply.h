@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef NETWORKMANAGERREPLY_H
+#define NETWORKMANAGERREPLY_H
+
+#include <QObject>
+#include <QPointer>
+#include <functional>
+#include <QDBusObjectPath>
+#include <QDBusPendingCall>
+#include <QDBusPendingCallWatcher>
+
+#include "networkmanager.h"
+
+class NetworkManagerReply : public QObject
+{
+    Q_OBJECT
+    friend class NetworkManager;
+
+public:
+    bool isFinished() const;
+    NetworkManager::NetworkManagerError error() const;
+
+    QDBusObjectPath connectionObjectPath() const;
+    QDBusObjectPath activeConnectionObjectPath() const;
+
+    void waitForFinished();
+
+signals:
+    void finished();
+
+private:
+    explicit NetworkManagerReply(QObject *parent = nullptr);
+
+    bool m_finished = false;
+    NetworkManager::NetworkManagerError m_error = NetworkManager::NetworkManagerErrorNoError;
+    QPointer<QDBusPendingCallWatcher> m_watcher;
+
+    // Note: a step waiting for a signal instead of a pending call, waitForFinished() runs it right away
+    std::function<void()> m_deferredStep;
+
+    // Connection request state
+    ConnectionSettings m_settings;
+    QDBusObjectPath m_deviceObjectPath;
+    NetworkManager::NetworkManagerError m_failureError = NetworkManager::NetworkManagerErrorUnknownError;
+    NetworkManager::ConnectionPersistence m_persistence = NetworkManager::ConnectionPersistenceDisk;
+    bool m_updated = false;
+    QList<QPointer<NetworkConnection>> m_obsoleteConnections;
+    QPointer<NetworkConnection> m_existingConnection;
+    ConnectionSettings m_existingSettings;
+    bool m_existingSettingsLoaded = false;
+    bool m_secretsLoaded = false;
+    QDBusObjectPath m_connectionObjectPath;
+    QDBusObjectPath m_activeConnectionObjectPath;
+
+    QDBusPendingCallWatcher *watch(const QDBusPendingCall &pendingCall);
+    void runDeferredStep();
+    void finish(NetworkManager::NetworkManagerError error);
+
+};
+
+#endif // NETWORKMANAGERREPLY_H
@@ -42,6 +42,11 @@ QString NetworkManagerUtils::NetworkManagerUtils::settingsPathString()
     return "/org/freedesktop/NetworkManager/Settings";
 }
 
+QString NetworkManagerUtils::objectManagerPathString()
+{
+    return "/org/freedesktop";
+}
+
 QString NetworkManagerUtils::NetworkManagerUtils::deviceInterfaceString()
 {
     return "org.freedesktop.NetworkManager.Device";
@@ -72,4 +77,14 @@ QString NetworkManagerUtils::connectionsInterfaceString()
     return "org.freedesktop.NetworkManager.Settings.Connection";
 }
 
+QString NetworkManagerUtils::activeConnectionInterfaceString()
+{
+    return "org.freedesktop.NetworkManager.Connection.Active";
+}
+
+QString NetworkManagerUtils::objectManagerInterfaceString()
+{
+    return "org.freedesktop.DBus.ObjectManager";
+}
+
 
@@ -28,11 +28,19 @@
 #include <QDebug>
 #include <QObject>
 #include <QString>
+#include <QVariantMap>
+#include <QDBusObjectPath>
 #include <QLoggingCategory>
 
 Q_DECLARE_LOGGING_CATEGORY(dcNetworkManager)
 Q_DECLARE_LOGGING_CATEGORY(dcNetworkManagerBluetoothServer)
 
+// Interface name -> properties of one DBus object
+typedef QMap<QString, QVariantMap> NMInterfacesMap;
+
+// Object path -> interfaces, as returned by org.freedesktop.DBus.ObjectManager.GetManagedObjects
+typedef QMap<QDBusObjectPath, NMInterfacesMap> NMManagedObjects;
+
 class NetworkManagerUtils
 {
     Q_GADGET
@@ -42,6 +50,7 @@ public:
 
     static QString networkManagerPathString();
     static QString settingsPathString();
+    static QString objectManagerPathString();
 
     static QString deviceInterfaceString();
     static QString wirelessInterfaceString();
@@ -49,6 +58,8 @@ public:
     static QString accessPointInterfaceString();
     static QString settingsInterfaceString();
     static QString connectionsInterfaceString();
+    static QString activeConnectionInterfaceString();
+    static QString objectManagerInterfaceString();
 
 };
 
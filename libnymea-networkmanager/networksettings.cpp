@@ -27,9 +27,16 @@
     \inmodule nymea-networkmanager
     \ingroup networkmanager
 
+    The summaries of the connections arrive asynchronously. Looking up a connection by uuid, id or
+    interface name while summaries are pending waits for them, the \l{summariesLoaded()} signal
+    allows to defer the lookup instead.
 
 */
 
+/*! \fn void NetworkSettings::summariesLoaded();
+    This signal will be emitted once the summaries of all connections have been loaded, i.e. after startup or after a connection has been updated.
+*/
+
 #include "networksettings.h"
 #include "networkmanagerutils.h"
 
@@ -39,39 +46,42 @@
 NetworkSettings::NetworkSettings(QObject *parent) :
     QObject(parent)
 {
-    qDBusRegisterMetaType<NMVariantMapList>();
-    qDBusRegisterMetaType<NMIntListList>();
-    qDBusRegisterMetaType<NMIntList>();
-
-    m_settingsInterface = new QDBusInterface(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), QDBusConnection::systemBus(), this);
-    if(!m_settingsInterface->isValid()) {
-        qCWarning(dcNetworkManager()) << "Invalid DBus network settings interface";
+    if (!initInterface())
         return;
-    }
 
     loadConnections();
+}
 
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), "NewConnection", this, SLOT(connectionAdded(QDBusObjectPath)));
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), "ConnectionRemoved", this, SLOT(connectionRemoved(QDBusObjectPath)));
-    // Networkmanager < 1.2.0 uses custom signal instead of the standard D-Bus properties changed signal
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), "PropertiesChanged", this, SLOT(processProperties(QVariantMap)));
-    // Networkmanager >= 1.2.0 uses standard D-Bus properties changed signal
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::settingsPathString(),  "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+/*! Constructs a new \l{NetworkSettings} object with the given \a parent.
+
+    The list of connections is taken from the given \a managedObjects instead of calling ListConnections.
+*/
+NetworkSettings::NetworkSettings(const NMManagedObjects &managedObjects, QObject *parent) :
+    QObject(parent)
+{
+    if (!initInterface())
+        return;
+
+    loadConnections(managedObjects);
 }
 
 /*! Add the given \a settings to this \l{NetworkSettings}. Returns the dbus object path from the new settings. */
 QDBusObjectPath NetworkSettings::addConnection(const ConnectionSettings &settings)
 {
-    QDBusMessage query = m_settingsInterface->call("AddConnection", QVariant::fromValue(settings));
-    if(query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcNetworkManager()) << query.errorName() << query.errorMessage();
+    QDBusPendingReply<QDBusObjectPath> reply = addConnectionAsync(settings);
+    reply.waitForFinished();
+    if (reply.isError()) {
+        qCWarning(dcNetworkManager()) << reply.error().name() << reply.error().message();
         return QDBusObjectPath();
     }
 
-    if (query.arguments().isEmpty())
-        return QDBusObjectPath();
+    return reply.value();
+}
 
-    return query.arguments().at(0).value<QDBusObjectPath>();
+/*! Add the given \a settings to this \l{NetworkSettings} without blocking. The returned pending reply contains the dbus object path of the new settings once finished. */
+QDBusPendingReply<QDBusObjectPath> NetworkSettings::addConnectionAsync(const ConnectionSettings &settings)
+{
+    return m_settingsInterface->asyncCall("AddConnection", QVariant::fromValue(settings));
 }
 
 /*! Returns the list of current \l{NetworkConnection}{NetworkConnections} from this \l{NetworkSettings}. */
@@ -80,6 +90,268 @@ QList<NetworkConnection *> NetworkSettings::connections() const
     return m_connections.values();
 }
 
+/*! Returns the \l{NetworkConnection} with the given \a objectPath, or nullptr if there is none. */
+NetworkConnection *NetworkSettings::getConnection(const QDBusObjectPath &objectPath) const
+{
+    return m_connections.value(objectPath, nullptr);
+}
+
+/*! Returns the \l{NetworkConnection} with the given \a uuid, or nullptr if there is none. */
+NetworkConnection *NetworkSettings::getConnection(const QUuid &uuid) const
+{
+    waitForConnections();
+    return m_connectionsByUuid.value(uuid, nullptr);
+}
+
+/*! Returns the list of \l{NetworkConnection}{NetworkConnections} with the given \a id. */
+QList<NetworkConnection *> NetworkSettings::getConnections(const QString &id) const
+{
+    waitForConnections();
+    return m_connectionsById.values(id);
+}
+
+/*! Returns the list of \l{NetworkConnection}{NetworkConnections} bound to the network interface with the given \a interfaceName. */
+QList<NetworkConnection *> NetworkSettings::getInterfaceConnections(const QString &interfaceName) const
+{
+    waitForConnections();
+    return m_connectionsByInterfaceName.values(interfaceName);
+}
+
+/*! Returns true if the summary of any connection is still loading. Lookups by uuid, id or interface name block until they arrived.
+
+    \sa summariesLoaded()
+*/
+bool NetworkSettings::summariesPending() const
+{
+    return !m_pendingSummaries.isEmpty();
+}
+
+/*! Returns the existing \l{NetworkConnection} matching the given \a settings, or nullptr if there is none.
+
+    A connection matches if it has the same uuid, or it has the same type and either the same id or,
+    for wireless connections, the same SSID. Wireless connections also need to use the same mode,
+    a hotspot never gets reused for a client connection and vice versa.
+
+    \sa connectionTypeMatches()
+*/
+NetworkConnection *NetworkSettings::findConnection(const ConnectionSettings &settings) const
+{
+    const QVariantMap connectionSettings = settings.value("connection");
+    const QUuid uuid = connectionSettings.value("uuid").toUuid();
+    const QString id = connectionSettings.value("id").toString();
+    const QByteArray ssid = settings.value("802-11-wireless").value("ssid").toByteArray();
+
+    if (!uuid.isNull()) {
+        NetworkConnection *connection = getConnection(uuid);
+        if (connection)
+            return connection;
+    }
+
+    foreach (NetworkConnection *connection, getConnections(id)) {
+        if (connectionTypeMatches(connection->type(), connection->wirelessMode(), settings))
+            return connection;
+    }
+
+    if (ssid.isEmpty())
+        return nullptr;
+
+    foreach (NetworkConnection *connection, m_connections) {
+        if (connection->ssid() == ssid && connectionTypeMatches(connection->type(), connection->wirelessMode(), settings))
+            return connection;
+    }
+
+    return nullptr;
+}
+
+/*! Returns true if a connection of the given \a type and \a wirelessMode can be reused for the given \a settings.
+
+    The type has to be the same. For wireless connections the mode has to be the same as well, a missing
+    mode counts as "infrastructure" like in the NetworkManager.
+*/
+bool NetworkSettings::connectionTypeMatches(const QString &type, const QString &wirelessMode, const ConnectionSettings &settings)
+{
+    if (type != settings.value("connection").value("type").toString())
+        return false;
+
+    if (type != "802-11-wireless")
+        return true;
+
+    const QString defaultWirelessMode = defaultSettings().value("802-11-wireless").value("mode").toString();
+    const QString requestedWirelessMode = settings.value("802-11-wireless").value("mode", defaultWirelessMode).toString();
+    return (wirelessMode.isEmpty() ? defaultWirelessMode : wirelessMode) == requestedWirelessMode;
+}
+
+/*! Returns the existing \a connectionSettings with all values of the given \a settings applied.
+
+    The uuid of the existing connection will be kept. The wireless security setting will be removed if the given \a settings don't contain one, i.e. for open networks.
+    Properties with a well known default value, like "hidden", are reset to their default if the given \a settings don't contain them.
+*/
+ConnectionSettings NetworkSettings::mergeSettings(const ConnectionSettings &connectionSettings, const ConnectionSettings &settings)
+{
+    const ConnectionSettings defaults = defaultSettings();
+    ConnectionSettings mergedSettings = connectionSettings;
+    foreach (const QString &settingName, settings.keys()) {
+        QVariantMap setting = mergedSettings.value(settingName);
+        const QVariantMap newSetting = settings.value(settingName);
+        for (QVariantMap::const_iterator it = newSetting.constBegin(); it != newSetting.constEnd(); ++it) {
+            setting.insert(it.key(), it.value());
+        }
+
+        foreach (const QString &key, defaults.value(settingName).keys()) {
+            if (!newSetting.contains(key)) {
+                setting.remove(key);
+            }
+        }
+        mergedSettings.insert(settingName, setting);
+    }
+
+    if (connectionSettings.value("connection").contains("uuid"))
+        mergedSettings["connection"].insert("uuid", connectionSettings.value("connection").value("uuid"));
+
+    if (!settings.contains("802-11-wireless-security"))
+        mergedSettings.remove("802-11-wireless-security");
+
+    return mergedSettings;
+}
+
+/*! Returns true if all values of the given \a settings, except the uuid, are already part of the existing \a connectionSettings.
+
+    The NetworkManager omits properties set to their default value, i.e. "autoconnect" or "hidden", those are compared with the
+    default value instead. Other values which are not part of the given \a settings are ignored, only the wireless security setting
+    must not exist if the given \a settings don't contain one.
+*/
+bool NetworkSettings::settingsApplied(const ConnectionSettings &connectionSettings, const ConnectionSettings &settings)
+{
+    if (!settings.contains("802-11-wireless-security") && connectionSettings.contains("802-11-wireless-security"))
+        return false;
+
+    const ConnectionSettings defaults = defaultSettings();
+    foreach (const QString &settingName, settings.keys()) {
+        const QVariantMap setting = connectionSettings.value(settingName);
+        const QVariantMap newSetting = settings.value(settingName);
+        const QVariantMap defaultSetting = defaults.value(settingName);
+        for (QVariantMap::const_iterator it = newSetting.constBegin(); it != newSetting.constEnd(); ++it) {
+            if (settingName == "connection" && it.key() == "uuid")
+                continue;
+
+            // Note: deprecated, the NetworkManager derives it from the existence of the security setting
+            if (settingName == "802-11-wireless" && it.key() == "security")
+                continue;
+
+            if (!settingValuesEqual(setting.value(it.key(), defaultSetting.value(it.key())), it.value()))
+                return false;
+        }
+
+        // Properties not given have to be at their default value
+        for (QVariantMap::const_iterator it = defaultSetting.constBegin(); it != defaultSetting.constEnd(); ++it) {
+            if (!newSetting.contains(it.key()) && setting.contains(it.key()) && !settingValuesEqual(setting.value(it.key()), it.value()))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+ConnectionSettings NetworkSettings::defaultSettings()
+{
+    // Note: only properties set by the NetworkManager class, https://networkmanager.dev/docs/api/latest/nm-settings-dbus.html
+    ConnectionSettings settings;
+    settings["connection"].insert("autoconnect", true);
+    settings["connection"].insert("autoconnect-retries", -1);
+    settings["802-11-wireless"].insert("mode", "infrastructure");
+    settings["802-11-wireless"].insert("hidden", false);
+    settings["802-11-wireless"].insert("powersave", 0);
+    return settings;
+}
+
+bool NetworkSettings::settingValuesEqual(const QVariant &value, const QVariant &otherValue)
+{
+    if (value.userType() == otherValue.userType())
+        return value == otherValue;
+
+    // Note: the dbus types differ from the ones used to build the settings, i.e. uint and int
+    bool valueOk = false;
+    bool otherValueOk = false;
+    qlonglong number = value.toLongLong(&valueOk);
+    qlonglong otherNumber = otherValue.toLongLong(&otherValueOk);
+    if (valueOk && otherValueOk)
+        return number == otherNumber;
+
+    return value == otherValue;
+}
+
+bool NetworkSettings::initInterface()
+{
+    qDBusRegisterMetaType<NMVariantMapList>();
+    qDBusRegisterMetaType<NMIntListList>();
+    qDBusRegisterMetaType<NMIntList>();
+
+    m_settingsInterface = new NetworkManagerDBusProxy(NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), QDBusConnection::systemBus(), this);
+    if(!m_settingsInterface->isValid()) {
+        qCWarning(dcNetworkManager()) << "Invalid DBus network settings interface";
+        return false;
+    }
+
+    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), "NewConnection", this, SLOT(connectionAdded(QDBusObjectPath)));
+    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), NetworkManagerUtils::settingsPathString(), NetworkManagerUtils::settingsInterfaceString(), "ConnectionRemoved", this, SLOT(connectionRemoved(QDBusObjectPath)));
+    // Note: one subscription for the Updated signal of all connections
+    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), QString(), NetworkManagerUtils::connectionsInterfaceString(), "Updated", this, SLOT(connectionUpdated(QDBusMessage)));
+    // Note: property changes get dispatched by the NetworkManager
+    return true;
+}
+
+void NetworkSettings::waitForConnections() const
+{
+    if (m_pendingSummaries.isEmpty())
+        return;
+
+    // Note: only blocks if a lookup happens before the summaries arrived. The set shrinks while waiting, iterate a copy.
+    const QList<NetworkConnection *> pendingConnections = m_pendingSummaries.values();
+    foreach (NetworkConnection *connection, pendingConnections) {
+        connection->waitForSummary();
+    }
+}
+
+void NetworkSettings::finishSummary(NetworkConnection *connection)
+{
+    if (m_pendingSummaries.remove(connection) && m_pendingSummaries.isEmpty())
+        emit summariesLoaded();
+}
+
+void NetworkSettings::indexConnection(NetworkConnection *connection)
+{
+    unindexConnection(connection);
+
+    IndexKeys keys;
+    keys.uuid = connection->m_uuid;
+    keys.id = connection->m_id;
+    keys.interfaceName = connection->m_interfaceName;
+    m_indexKeys.insert(connection, keys);
+
+    if (!keys.uuid.isNull())
+        m_connectionsByUuid.insert(keys.uuid, connection);
+
+    m_connectionsById.insert(keys.id, connection);
+
+    if (!keys.interfaceName.isEmpty())
+        m_connectionsByInterfaceName.insert(keys.interfaceName, connection);
+}
+
+void NetworkSettings::unindexConnection(NetworkConnection *connection)
+{
+    if (!m_indexKeys.contains(connection))
+        return;
+
+    const IndexKeys keys = m_indexKeys.take(connection);
+
+    // Note: only drop the uuid entry if it still belongs to this connection
+    if (m_connectionsByUuid.value(keys.uuid) == connection)
+        m_connectionsByUuid.remove(keys.uuid);
+
+    m_connectionsById.remove(keys.id, connection);
+    m_connectionsByInterfaceName.remove(keys.interfaceName, connection);
+}
+
 void NetworkSettings::loadConnections()
 {
     qCDebug(dcNetworkManager()) << "Load connection list";
@@ -102,32 +374,88 @@ void NetworkSettings::loadConnections()
 
 }
 
+void NetworkSettings::loadConnections(const NMManagedObjects &managedObjects)
+{
+    qCDebug(dcNetworkManager()) << "Load connection list from managed objects";
+    foreach (const QDBusObjectPath &objectPath, managedObjects.keys()) {
+        if (managedObjects.value(objectPath).contains(NetworkManagerUtils::connectionsInterfaceString())) {
+            connectionAdded(objectPath);
+        }
+    }
+}
+
 void NetworkSettings::connectionAdded(const QDBusObjectPath &objectPath)
 {
+    if (m_connections.contains(objectPath))
+        return;
+
+    // Note: the summary of the connection arrives asynchronously
     NetworkConnection *connection = new NetworkConnection(objectPath, this);
     m_connections.insert(objectPath, connection);
+    if (!connection->m_summaryWatcher.isNull())
+        m_pendingSummaries.insert(connection);
 
-    qCDebug(dcNetworkManager()) << "Settings: [+]" << connection;
+    connect(connection, &NetworkConnection::summaryChanged, this, [this, connection](){
+        // Note: the connection might have been removed while its settings were loading
+        if (m_connections.value(connection->objectPath()) != connection)
+            return;
+
+        indexConnection(connection);
+        qCDebug(dcNetworkManager()) << "Settings:" << connection;
+        finishSummary(connection);
+    });
+    connect(connection, &NetworkConnection::summaryLoadFailed, this, [this, connection](){
+        finishSummary(connection);
+    });
+    qCDebug(dcNetworkManager()) << "Settings: [+]" << objectPath.path();
 }
 
 void NetworkSettings::connectionRemoved(const QDBusObjectPath &objectPath)
 {
     NetworkConnection *connection = m_connections.take(objectPath);
-    qCDebug(dcNetworkManager()) << "Settings: [-]" << connection;
+    if (!connection)
+        return;
+
+    unindexConnection(connection);
+    qCDebug(dcNetworkManager()) << "Settings: [-]" << objectPath.path();
+    finishSummary(connection);
     connection->deleteLater();
 }
 
-void NetworkSettings::onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties)
+void NetworkSettings::connectionUpdated(const QDBusMessage &message)
 {
-    Q_UNUSED(interface)
-    Q_UNUSED(invalidatedProperties)
-    //qCDebug(dcNetworkManager()) << "Settins: Properties changed" << interface << changedProperties << invalidatedProperties;
-    processProperties(changedProperties);
+    NetworkConnection *connection = m_connections.value(QDBusObjectPath(message.path()), nullptr);
+    if (!connection)
+        return;
+
+    // Note: the indexes get updated once the new summary arrived
+    qCDebug(dcNetworkManager()) << "Settings: [~]" << message.path();
+    connection->reload();
+    if (!connection->m_summaryWatcher.isNull())
+        m_pendingSummaries.insert(connection);
 }
 
 void NetworkSettings::processProperties(const QVariantMap &properties)
 {
-    Q_UNUSED(properties)
+    // Note: the Connections property catches up with NewConnection or ConnectionRemoved signals which got lost
+    if (!properties.contains("Connections"))
+        return;
+
+    const QList<QDBusObjectPath> objectPaths = qdbus_cast<QList<QDBusObjectPath>>(properties.value("Connections"));
+#if QT_VERSION >= QT_VERSION_CHECK(5,14,0)
+    const QSet<QDBusObjectPath> objectPathSet(objectPaths.constBegin(), objectPaths.constEnd());
+#else
+    const QSet<QDBusObjectPath> objectPathSet = objectPaths.toSet();
+#endif
+    foreach (const QDBusObjectPath &objectPath, m_connections.keys()) {
+        if (!objectPathSet.contains(objectPath)) {
+            connectionRemoved(objectPath);
+        }
+    }
+
+    foreach (const QDBusObjectPath &objectPath, objectPaths) {
+        connectionAdded(objectPath);
+    }
 }
 
 
@@ -25,13 +25,18 @@
 #ifndef NETWORKSETTINGS_H
 #define NETWORKSETTINGS_H
 
+#include <QHash>
 #include <QObject>
+#include <QSet>
+#include <QDBusMessage>
 #include <QDBusObjectPath>
 #include <QDBusConnection>
-#include <QDBusInterface>
 #include <QDBusArgument>
+#include <QDBusPendingReply>
 
 #include "networkconnection.h"
+#include "networkmanagerutils.h"
+#include "networkmanagerdbusproxy.h"
 
 class NetworkConnection;
 
@@ -47,22 +52,63 @@ Q_DECLARE_METATYPE(NMIntList)
 class NetworkSettings : public QObject
 {
     Q_OBJECT
+    friend class NetworkManager;
+
 public:
     explicit NetworkSettings(QObject *parent = nullptr);
+    explicit NetworkSettings(const NMManagedObjects &managedObjects, QObject *parent = nullptr);
 
     QDBusObjectPath addConnection(const ConnectionSettings &settings);
+    QDBusPendingReply<QDBusObjectPath> addConnectionAsync(const ConnectionSettings &settings);
     QList<NetworkConnection *> connections() const;
+    NetworkConnection *getConnection(const QDBusObjectPath &objectPath) const;
+    NetworkConnection *getConnection(const QUuid &uuid) const;
+    QList<NetworkConnection *> getConnections(const QString &id) const;
+    QList<NetworkConnection *> getInterfaceConnections(const QString &interfaceName) const;
+
+    bool summariesPending() const;
+
+    NetworkConnection *findConnection(const ConnectionSettings &settings) const;
+    static bool connectionTypeMatches(const QString &type, const QString &wirelessMode, const ConnectionSettings &settings);
+    static ConnectionSettings mergeSettings(const ConnectionSettings &connectionSettings, const ConnectionSettings &settings);
+    static bool settingsApplied(const ConnectionSettings &connectionSettings, const ConnectionSettings &settings);
 
 private:
-    QDBusInterface *m_settingsInterface = nullptr;
+    static ConnectionSettings defaultSettings();
+    static bool settingValuesEqual(const QVariant &value, const QVariant &otherValue);
+
+    NetworkManagerDBusProxy *m_settingsInterface = nullptr;
     QHash<QDBusObjectPath, NetworkConnection *> m_connections;
 
+    // Secondary indexes, updated whenever the summary of a connection arrives
+    struct IndexKeys {
+        QUuid uuid;
+        QString id;
+        QString interfaceName;
+    };
+    QHash<NetworkConnection *, IndexKeys> m_indexKeys;
+    QHash<QUuid, NetworkConnection *> m_connectionsByUuid;
+    QMultiHash<QString, NetworkConnection *> m_connectionsById;
+    QMultiHash<QString, NetworkConnection *> m_connectionsByInterfaceName;
+
+    // Connections whose summary is still loading, the indexes are complete once this is empty
+    QSet<NetworkConnection *> m_pendingSummaries;
+
+    bool initInterface();
+    void waitForConnections() const;
+    void finishSummary(NetworkConnection *connection);
+    void indexConnection(NetworkConnection *connection);
+    void unindexConnection(NetworkConnection *connection);
     void loadConnections();
+    void loadConnections(const NMManagedObjects &managedObjects);
+
+signals:
+    void summariesLoaded();
 
 private slots:
     void connectionAdded(const QDBusObjectPath &objectPath);
     void connectionRemoved(const QDBusObjectPath &objectPath);
-    void onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties);
+    void connectionUpdated(const QDBusMessage &message);
     void processProperties(const QVariantMap &properties);
 
 };
@@ -38,26 +38,29 @@
 WiredNetworkDevice::WiredNetworkDevice(const QDBusObjectPath &objectPath, QObject *parent) :
     NetworkDevice(objectPath, parent)
 {
-    QDBusConnection systemBus = QDBusConnection::systemBus();
-    if (!systemBus.isConnected()) {
-        qCWarning(dcNetworkManager()) << "WiredNetworkDevice: System DBus not connected";
+    if (!initWiredInterface())
         return;
-    }
 
-    m_wiredInterface = new QDBusInterface(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), NetworkManagerUtils::wiredInterfaceString(), systemBus, this);
-    if(!m_wiredInterface->isValid()) {
-        qCWarning(dcNetworkManager()) << "WiredNetworkDevice: Invalid wired dbus interface";
-        return;
-    }
+    const QVariantMap properties = m_wiredInterface->readProperties();
+    m_macAddress = properties.value("HwAddress").toString();
+    m_bitRate = properties.value("Bitrate").toInt();
+    m_pluggedIn = properties.value("Carrier").toBool();
+}
+
+/*! Constructs a new \l{WiredNetworkDevice} with the given dbus \a objectPath and \a parent.
 
-    m_macAddress = m_wiredInterface->property("HwAddress").toString();
-    m_bitRate = m_wiredInterface->property("Bitrate").toInt();
-    m_pluggedIn = m_wiredInterface->property("Carrier").toBool();
+    The device properties are taken from the given \a managedObjects instead of reading them one by one from the bus.
+*/
+WiredNetworkDevice::WiredNetworkDevice(const QDBusObjectPath &objectPath, const NMManagedObjects &managedObjects, QObject *parent) :
+    NetworkDevice(objectPath, managedObjects, parent)
+{
+    if (!initWiredInterface())
+        return;
 
-    // Networkmanager < 1.2.0 uses custom signal instead of the standard D-Bus properties changed signal
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), NetworkManagerUtils::wiredInterfaceString(), "PropertiesChanged", this, SLOT(processProperties(QVariantMap)));
-    // Networkmanager >= 1.2.0 uses standard D-Bus properties changed signal
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(propertiesChanged(QString, QVariantMap, QStringList)));
+    const QVariantMap properties = managedObjects.value(objectPath).value(NetworkManagerUtils::wiredInterfaceString());
+    m_macAddress = properties.value("HwAddress").toString();
+    m_bitRate = properties.value("Bitrate").toInt();
+    m_pluggedIn = properties.value("Carrier").toBool();
 }
 
 /*! Returns the mac address of this \l{WiredNetworkDevice}. */
@@ -78,22 +81,40 @@ bool WiredNetworkDevice::pluggedIn() const
     return m_pluggedIn;
 }
 
-void WiredNetworkDevice::onPropertiesChanged(const QString &interfaceName, const QVariantMap &changedProperties, const QStringList &invalidatedProperties)
-{
-    Q_UNUSED(interfaceName)
-    Q_UNUSED(invalidatedProperties)
-    //qCDebug(dcNetworkManager()) << "WiredNetworkDevice: Properties changed" << interface << changedProperties << invalidatedProperties;
-    processProperties(changedProperties);
-}
-
 void WiredNetworkDevice::processProperties(const QVariantMap &properties)
 {
-    if (properties.contains("Carrier")) {
+    DeviceChanges changes = DeviceChangeNone;
+
+    if (properties.contains("Carrier") && m_pluggedIn != properties.value("Carrier").toBool()) {
         m_pluggedIn = properties.value("Carrier").toBool();
         emit pluggedInChanged(m_pluggedIn);
+        changes |= DeviceChangePluggedIn;
+    }
+
+    if (properties.contains("Bitrate") && m_bitRate != properties.value("Bitrate").toInt()) {
+        m_bitRate = properties.value("Bitrate").toInt();
+        changes |= DeviceChangeBitRate;
+    }
+
+    notifyDeviceChanged(changes);
+}
+
+bool WiredNetworkDevice::initWiredInterface()
+{
+    QDBusConnection systemBus = QDBusConnection::systemBus();
+    if (!systemBus.isConnected()) {
+        qCWarning(dcNetworkManager()) << "WiredNetworkDevice: System DBus not connected";
+        return false;
+    }
+
+    m_wiredInterface = new NetworkManagerDBusProxy(this->objectPath().path(), NetworkManagerUtils::wiredInterfaceString(), systemBus, this);
+    if(!m_wiredInterface->isValid()) {
+        qCWarning(dcNetworkManager()) << "WiredNetworkDevice: Invalid wired dbus interface";
+        return false;
     }
 
-    emit deviceChanged();
+    // Note: property changes get dispatched by the NetworkManager
+    return true;
 }
 
 QDebug operator<<(QDebug debug, WiredNetworkDevice *networkDevice)
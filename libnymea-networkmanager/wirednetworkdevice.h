@@ -33,8 +33,11 @@
 class WiredNetworkDevice : public NetworkDevice
 {
     Q_OBJECT
+    friend class NetworkManager;
+
 public:
     explicit WiredNetworkDevice(const QDBusObjectPath &objectPath, QObject *parent = nullptr);
+    explicit WiredNetworkDevice(const QDBusObjectPath &objectPath, const NMManagedObjects &managedObjects, QObject *parent = nullptr);
 
     QString macAddress() const;
     int bitRate() const;
@@ -44,11 +47,12 @@ signals:
     void pluggedInChanged(bool pluggedIn);
 
 private slots:
-    void onPropertiesChanged(const QString &interfaceName, const QVariantMap &changedProperties, const QStringList &invalidatedProperties);
     void processProperties(const QVariantMap &properties);
 
 private:
-    QDBusInterface *m_wiredInterface = nullptr;
+    NetworkManagerDBusProxy *m_wiredInterface = nullptr;
+
+    bool initWiredInterface();
 
     QString m_macAddress;
     int m_bitRate = 0;
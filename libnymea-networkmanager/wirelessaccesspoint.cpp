@@ -51,36 +51,51 @@
 
 #include "wirelessaccesspoint.h"
 #include "networkmanagerutils.h"
+#include "networkmanagerdbusproxy.h"
 
 /*! Constructs a new \l{WirelessAccessPoint} with the given dbus \a objectPath and \a parent. */
 WirelessAccessPoint::WirelessAccessPoint(const QDBusObjectPath &objectPath, QObject *parent) :
     QObject(parent),
     m_objectPath(objectPath)
 {
-    QDBusInterface accessPointInterface(NetworkManagerUtils::networkManagerServiceString(), m_objectPath.path(), NetworkManagerUtils::accessPointInterfaceString(), QDBusConnection::systemBus());
-    if(!accessPointInterface.isValid()) {
+    NetworkManagerDBusProxy accessPointInterface(m_objectPath.path(), NetworkManagerUtils::accessPointInterfaceString());
+    const QVariantMap properties = accessPointInterface.readProperties();
+    if(properties.isEmpty()) {
         qCWarning(dcNetworkManager()) << "Invalid access point dbus interface";
         return;
     }
 
     // Init properties
-    setSsid(accessPointInterface.property("Ssid").toString());
-    setMacAddress(accessPointInterface.property("HwAddress").toString());
-    setFrequency(accessPointInterface.property("Frequency").toDouble() / 1000);
-    setSignalStrength(accessPointInterface.property("Strength").toInt());
-    m_capabilities = static_cast<WirelessAccessPoint::ApFlags>(accessPointInterface.property("Flags").toUInt());
-    setWpaFlags(WirelessAccessPoint::ApSecurityModes(accessPointInterface.property("WpaFlags").toUInt()));
-    setRsnFlags(WirelessAccessPoint::ApSecurityModes(accessPointInterface.property("RsnFlags").toUInt()));
+    setSsid(properties.value("Ssid").toString());
+    setMacAddress(properties.value("HwAddress").toString());
+    setFrequency(properties.value("Frequency").toDouble() / 1000);
+    setSignalStrength(properties.value("Strength").toInt());
+    m_capabilities = static_cast<WirelessAccessPoint::ApFlags>(properties.value("Flags").toUInt());
+    setWpaFlags(WirelessAccessPoint::ApSecurityModes(properties.value("WpaFlags").toUInt()));
+    setRsnFlags(WirelessAccessPoint::ApSecurityModes(properties.value("RsnFlags").toUInt()));
     setIsProtected(m_rsnFlags != 0);
 
     qCDebug(dcNetworkManager()) << ssid() << "WPA flags:" << m_wpaFlags;
     qCDebug(dcNetworkManager()) << ssid() << "RSN flags:" << m_rsnFlags;
     qCDebug(dcNetworkManager()) << ssid() << "Capabilities:" << m_capabilities;
+}
+
+/*! Constructs a new \l{WirelessAccessPoint} with the given dbus \a objectPath and \a parent from the already known access point \a properties.
 
-    // Networkmanager < 1.2.0 uses custom signal instead of the standard D-Bus properties changed signal
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), NetworkManagerUtils::accessPointInterfaceString(), "PropertiesChanged", this, SLOT(processProperties(QVariantMap)));
-    // Networkmanager >= 1.2.0 uses standard D-Bus properties changed signal
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), objectPath.path(),  "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+    This avoids reading every property one by one, i.e. when the properties have been fetched using GetManagedObjects.
+*/
+WirelessAccessPoint::WirelessAccessPoint(const QDBusObjectPath &objectPath, const QVariantMap &properties, QObject *parent) :
+    QObject(parent),
+    m_objectPath(objectPath)
+{
+    setSsid(properties.value("Ssid").toString());
+    setMacAddress(properties.value("HwAddress").toString());
+    setFrequency(properties.value("Frequency").toDouble() / 1000);
+    setSignalStrength(properties.value("Strength").toInt());
+    m_capabilities = static_cast<WirelessAccessPoint::ApFlags>(properties.value("Flags").toUInt());
+    setWpaFlags(WirelessAccessPoint::ApSecurityModes(properties.value("WpaFlags").toUInt()));
+    setRsnFlags(WirelessAccessPoint::ApSecurityModes(properties.value("RsnFlags").toUInt()));
+    setIsProtected(m_rsnFlags != 0);
 }
 
 /*! Returns the dbus object path of this \l{WirelessAccessPoint}. */
@@ -130,6 +145,9 @@ int WirelessAccessPoint::signalStrength() const
 
 void WirelessAccessPoint::setSignalStrength(int signalStrength)
 {
+    if (m_signalStrength == signalStrength)
+        return;
+
     m_signalStrength = signalStrength;
     emit signalStrengthChanged();
 }
@@ -149,14 +167,6 @@ void WirelessAccessPoint::setIsProtected(bool isProtected)
     m_isProtected = isProtected;
 }
 
-void WirelessAccessPoint::onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties)
-{
-    Q_UNUSED(interface)
-    Q_UNUSED(invalidatedProperties)
-    //qCDebug(dcNetworkManager()) << "WirelessAccessPoint: Properties changed" << interface << changedProperties << invalidatedProperties;
-    processProperties(changedProperties);
-}
-
 void WirelessAccessPoint::processProperties(const QVariantMap &properties)
 {
     if (properties.contains("Strength"))
@@ -169,6 +179,15 @@ bool WirelessAccessPoint::isProtected() const
     return m_isProtected;
 }
 
+/*! Returns the access point generation of the parent \l{WirelessNetworkDevice} in which this \l{WirelessAccessPoint} has been added or changed the last time.
+
+    \sa WirelessNetworkDevice::accessPointGeneration()
+*/
+quint32 WirelessAccessPoint::generation() const
+{
+    return m_generation;
+}
+
 WirelessAccessPoint::ApFlags WirelessAccessPoint::capabilities() const
 {
     return m_capabilities;
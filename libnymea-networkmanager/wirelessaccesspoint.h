@@ -30,12 +30,13 @@
 #include <QFlags>
 #include <QDBusObjectPath>
 #include <QDBusConnection>
-#include <QDBusInterface>
 #include <QDBusArgument>
 
 class WirelessAccessPoint : public QObject
 {
     Q_OBJECT
+    friend class NetworkManager;
+    friend class WirelessNetworkDevice;
 
 public:
     enum ApSecurityMode {
@@ -67,6 +68,7 @@ public:
     Q_FLAG(ApCapabilities)
 
     explicit WirelessAccessPoint(const QDBusObjectPath &objectPath, QObject *parent = nullptr);
+    explicit WirelessAccessPoint(const QDBusObjectPath &objectPath, const QVariantMap &properties, QObject *parent = nullptr);
 
     QDBusObjectPath objectPath() const;
 
@@ -75,6 +77,7 @@ public:
     double frequency() const;
     int signalStrength() const;
     bool isProtected() const;
+    quint32 generation() const;
 
     WirelessAccessPoint::ApFlags capabilities() const;
     WirelessAccessPoint::ApSecurityModes wpaFlags() const;
@@ -87,6 +90,7 @@ private:
     double m_frequency;
     int m_signalStrength = 0;
     bool m_isProtected = false;
+    quint32 m_generation = 0;
     WirelessAccessPoint::ApFlags m_capabilities = ApCapabilitiesNone;
     WirelessAccessPoint::ApSecurityModes m_wpaFlags = ApSecurityModeNone;
     WirelessAccessPoint::ApSecurityModes m_rsnFlags = ApSecurityModeNone;
@@ -103,7 +107,6 @@ signals:
     void signalStrengthChanged();
 
 private slots:
-    void onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties);
     void processProperties(const QVariantMap &properties);
 
 };
@@ -42,6 +42,38 @@
     This signal will be emitted when the \a bitRate of this \l{WirelessNetworkDevice} has changed.
 */
 
+/*! \fn void WirelessNetworkDevice::lastScanChanged(qint64 lastScan);
+    This signal will be emitted when the \a lastScan timestamp of this \l{WirelessNetworkDevice} has changed.
+*/
+
+/*! \fn void WirelessNetworkDevice::scanFinished();
+    This signal will be emitted when a wireless network scan of this \l{WirelessNetworkDevice} has finished.
+
+    \sa requestScan()
+*/
+
+/*! \fn void WirelessNetworkDevice::accessPointsChanged();
+    This signal will be emitted once per batch of added or removed \l{WirelessAccessPoint}{WirelessAccessPoints}.
+
+    Access points reported by the NetworkManager within a short period of time, i.e. during a scan,
+    are loaded together and result in a single notification.
+*/
+
+/*! \fn void WirelessNetworkDevice::accessPointGenerationChanged(quint32 generation);
+    This signal will be emitted whenever a \l{WirelessAccessPoint} has been added, removed or changed its signal strength.
+    The new access point \a generation can be used to fetch the changes.
+
+    \sa accessPointsChangedSince(), accessPointsRemovedSince()
+*/
+
+/*! \fn void WirelessNetworkDevice::accessPointLoaded(WirelessAccessPoint *accessPoint);
+    This signal will be emitted once the given \a accessPoint has been loaded and added to the list of access points.
+*/
+
+/*! \fn void WirelessNetworkDevice::accessPointUnloaded(WirelessAccessPoint *accessPoint);
+    This signal will be emitted when the given \a accessPoint has been removed from the list of access points. It gets deleted afterwards.
+*/
+
 /*! \fn void WirelessNetworkDevice::modeChanged(Mode mode);
     This signal will be emitted when the current \a mode of this \l{WirelessNetworkDevice} has changed.
 
@@ -51,41 +83,52 @@
 #include "networkmanagerutils.h"
 #include "wirelessnetworkdevice.h"
 
+#include <time.h>
+
 #include <QUuid>
 #include <QDebug>
 #include <QMetaEnum>
+#include <QDBusPendingCallWatcher>
 
 /*! Constructs a new \l{WirelessNetworkDevice} with the given dbus \a objectPath and \a parent. */
 WirelessNetworkDevice::WirelessNetworkDevice(const QDBusObjectPath &objectPath, QObject *parent) :
     NetworkDevice(objectPath, parent),
     m_activeAccessPoint(nullptr)
 {
-    QDBusConnection systemBus = QDBusConnection::systemBus();
-    if (!systemBus.isConnected()) {
-        qCWarning(dcNetworkManager()) << "WirelessNetworkDevice: System DBus not connected";
+    if (!initWirelessInterface())
         return;
-    }
 
-    m_wirelessInterface = new QDBusInterface(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), NetworkManagerUtils::wirelessInterfaceString(), systemBus, this);
-    if (!m_wirelessInterface->isValid()) {
-        qCWarning(dcNetworkManager()) << "WirelessNetworkDevice: Invalid wireless dbus interface";
-        return;
-    }
+    readAccessPoints();
 
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), NetworkManagerUtils::wirelessInterfaceString(), "AccessPointAdded", this, SLOT(accessPointAdded(QDBusObjectPath)));
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), NetworkManagerUtils::wirelessInterfaceString(), "AccessPointRemoved", this, SLOT(accessPointRemoved(QDBusObjectPath)));
-    // org.freedesktop.NetworkManager.Device.Wireless.PropertiesChanged(QVariantMap) is used in older versions of NetworkManager instead of the standard D-Bus properties changed signal
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), NetworkManagerUtils::wirelessInterfaceString(), "PropertiesChanged", this, SLOT(processProperties(QVariantMap)));
-    // Newer versions of NetworkManager dropped the other and switched to the D-Bus standard PropertiesChanged
-    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QString, QVariantMap, QStringList)));
+    const QVariantMap properties = m_wirelessInterface->readProperties();
+    m_macAddress = properties.value("HwAddress").toString();
+    m_wirelessCapabilities = static_cast<WirelessCapabilities>(properties.value("WirelessCapabilities").toUInt());
+    m_wirelessMode = static_cast<WirelessMode>(properties.value("Mode").toUInt());
+    m_bitRate = properties.value("Bitrate").toInt() / 1000;
+    m_lastScan = properties.value("LastScan", -1).toLongLong();
+    setActiveAccessPoint(qdbus_cast<QDBusObjectPath>(properties.value("ActiveAccessPoint")));
+}
 
-    readAccessPoints();
+/*! Constructs a new \l{WirelessNetworkDevice} with the given dbus \a objectPath and \a parent.
+
+    The device and access point properties are taken from the given \a managedObjects instead of reading them one by one from the bus.
+*/
+WirelessNetworkDevice::WirelessNetworkDevice(const QDBusObjectPath &objectPath, const NMManagedObjects &managedObjects, QObject *parent) :
+    NetworkDevice(objectPath, managedObjects, parent),
+    m_activeAccessPoint(nullptr)
+{
+    if (!initWirelessInterface())
+        return;
+
+    const QVariantMap properties = managedObjects.value(objectPath).value(NetworkManagerUtils::wirelessInterfaceString());
+    readAccessPoints(properties.value("AccessPoints"), managedObjects);
 
-    m_macAddress = m_wirelessInterface->property("HwAddress").toString();
-    m_wirelessCapabilities = static_cast<WirelessCapabilities>(m_wirelessInterface->property("WirelessCapabilities").toUInt());
-    m_wirelessMode = static_cast<WirelessMode>(m_wirelessInterface->property("Mode").toUInt());
-    m_bitRate = m_wirelessInterface->property("Bitrate").toInt() / 1000;
-    setActiveAccessPoint(qdbus_cast<QDBusObjectPath>(m_wirelessInterface->property("ActiveAccessPoint")));
+    m_macAddress = properties.value("HwAddress").toString();
+    m_wirelessCapabilities = static_cast<WirelessCapabilities>(properties.value("WirelessCapabilities").toUInt());
+    m_wirelessMode = static_cast<WirelessMode>(properties.value("Mode").toUInt());
+    m_bitRate = properties.value("Bitrate").toInt() / 1000;
+    m_lastScan = properties.value("LastScan", -1).toLongLong();
+    setActiveAccessPoint(qdbus_cast<QDBusObjectPath>(properties.value("ActiveAccessPoint")));
 }
 
 /*! Returns the mac address of this \l{WirelessNetworkDevice}. */
@@ -119,29 +162,114 @@ WirelessAccessPoint *WirelessNetworkDevice::activeAccessPoint()
 /*! Perform a wireless network scan on this \l{WirelessNetworkDevice}. */
 void WirelessNetworkDevice::scanWirelessNetworks()
 {
-    qCDebug(dcNetworkManager()) << "Request scan" << this;
-    QDBusMessage query = m_wirelessInterface->call("RequestScan", QVariantMap());
-    if (query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcNetworkManager()) << "Scan error:" << query.errorName() << query.errorMessage();
+    QDBusPendingReply<> reply = scanWirelessNetworksAsync();
+    reply.waitForFinished();
+    if (reply.isError()) {
+        qCWarning(dcNetworkManager()) << "Scan error:" << reply.error().name() << reply.error().message();
         return;
     }
 }
 
+/*! Request a wireless network scan on this \l{WirelessNetworkDevice} without blocking. The returned pending reply finishes once NetworkManager accepted the scan request. */
+QDBusPendingReply<> WirelessNetworkDevice::scanWirelessNetworksAsync()
+{
+    qCDebug(dcNetworkManager()) << "Request scan" << this;
+    return m_wirelessInterface->asyncCall("RequestScan", QVariantMap());
+}
+
+/*! Returns the time in milliseconds (CLOCK_BOOTTIME) of the last finished scan of this \l{WirelessNetworkDevice}. Returns -1 if the device has never scanned or the NetworkManager does not provide this information (< 1.12). */
+qint64 WirelessNetworkDevice::lastScan() const
+{
+    return m_lastScan;
+}
+
+/*! Returns the age in milliseconds of the current scan results of this \l{WirelessNetworkDevice}. Returns -1 if the age is unknown. */
+qint64 WirelessNetworkDevice::lastScanAge() const
+{
+    if (m_lastScan >= 0) {
+        // Note: LastScan is based on CLOCK_BOOTTIME
+        struct timespec now;
+        if (clock_gettime(CLOCK_BOOTTIME, &now) == 0)
+            return qMax(Q_INT64_C(0), static_cast<qint64>(now.tv_sec) * 1000 + now.tv_nsec / 1000000 - m_lastScan);
+    }
+
+    // Fallback for NetworkManager versions without the LastScan property
+    if (m_scanFinishedTimer.isValid())
+        return m_scanFinishedTimer.elapsed();
+
+    return -1;
+}
+
+/*! Returns true if a scan requested using \l{requestScan()} is currently running. */
+bool WirelessNetworkDevice::scanning() const
+{
+    return m_scanning;
+}
+
+/*! Returns the maximum age in milliseconds of scan results which will be served without scanning again. \sa requestScan() */
+int WirelessNetworkDevice::scanMaxAge() const
+{
+    return m_scanMaxAge;
+}
+
+/*! Sets the maximum age in milliseconds of scan results which will be served without scanning again to \a scanMaxAge. \sa requestScan() */
+void WirelessNetworkDevice::setScanMaxAge(int scanMaxAge)
+{
+    m_scanMaxAge = qMax(0, scanMaxAge);
+}
+
+/*! Request a wireless network scan on this \l{WirelessNetworkDevice} unless the current results are younger than \l{scanMaxAge()}.
+
+    Concurrent requests get collapsed into one scan. If \a force is true, the age of the current results will be ignored.
+    Returns true if a scan is running and \l{scanFinished()} will be emitted, false if the cached results are recent enough.
+*/
+bool WirelessNetworkDevice::requestScan(bool force)
+{
+    if (m_scanning) {
+        qCDebug(dcNetworkManager()) << this << "Scan already running";
+        return true;
+    }
+
+    qint64 age = lastScanAge();
+    if (!force && age >= 0 && age <= m_scanMaxAge) {
+        qCDebug(dcNetworkManager()) << this << "Using scan results from" << age << "ms ago";
+        return false;
+    }
+
+    m_scanning = true;
+    m_scanTimeoutTimer->start();
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(scanWirelessNetworksAsync(), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *call){
+        call->deleteLater();
+
+        QDBusPendingReply<> reply = *call;
+        if (reply.isError()) {
+            qCWarning(dcNetworkManager()) << "Scan error:" << reply.error().name() << reply.error().message();
+            finishScan();
+        }
+    });
+    return true;
+}
+
 /*! Returns the list of all \l{WirelessAccessPoint}{WirelessAccessPoints} of this \l{WirelessNetworkDevice}. */
 QList<WirelessAccessPoint *> WirelessNetworkDevice::accessPoints()
 {
     return m_accessPointsTable.values();
 }
 
-/*! Returns the \l{WirelessAccessPoint} with the given \a ssid. If the \l{WirelessAccessPoint} could not be found, return nullptr. */
+/*! Returns the \l{WirelessAccessPoint} with the given \a ssid. If there are multiple access points for this \a ssid, the one with the best signal strength will be returned. If the \l{WirelessAccessPoint} could not be found, return nullptr. */
 WirelessAccessPoint *WirelessNetworkDevice::getAccessPoint(const QString &ssid)
 {
-    foreach (WirelessAccessPoint *accessPoint, m_accessPointsTable.values()) {
-        if (accessPoint->ssid() == ssid)
-            return accessPoint;
-    }
-    return nullptr;
+    WirelessAccessPoint *bestAccessPoint = nullptr;
+    QMultiHash<QString, WirelessAccessPoint *>::const_iterator it = m_accessPointsBySsid.constFind(ssid);
+    while (it != m_accessPointsBySsid.constEnd() && it.key() == ssid) {
+        if (!bestAccessPoint || it.value()->signalStrength() > bestAccessPoint->signalStrength())
+            bestAccessPoint = it.value();
 
+        ++it;
+    }
+    return bestAccessPoint;
 }
 
 /*! Returns the \l{WirelessAccessPoint} with the given \a objectPath. If the \l{WirelessAccessPoint} could not be found, return nullptr. */
@@ -150,6 +278,88 @@ WirelessAccessPoint *WirelessNetworkDevice::getAccessPoint(const QDBusObjectPath
     return m_accessPointsTable.value(objectPath);
 }
 
+/*! Returns the \l{WirelessAccessPoint} with the given \a bssid (mac address). If the \l{WirelessAccessPoint} could not be found, return nullptr. */
+WirelessAccessPoint *WirelessNetworkDevice::getAccessPointByBssid(const QString &bssid)
+{
+    return m_accessPointsByBssid.value(bssid.toUpper());
+}
+
+/*! Returns the current access point generation of this \l{WirelessNetworkDevice}.
+
+    The generation gets incremented whenever a \l{WirelessAccessPoint} has been added, removed or changed its signal strength.
+    The generation is only valid for the lifetime of this object.
+
+    \sa accessPointsChangedSince(), accessPointsRemovedSince()
+*/
+quint32 WirelessNetworkDevice::accessPointGeneration() const
+{
+    return m_accessPointGeneration;
+}
+
+/*! Returns true if the changes since the given \a generation are still known. If not, i.e. if too many access points have been removed in the meantime, the full access point list has to be used. */
+bool WirelessNetworkDevice::accessPointChangesAvailable(quint32 generation) const
+{
+    return generation > 0 && generation >= m_accessPointGenerationHorizon && generation <= m_accessPointGeneration;
+}
+
+/*! Returns the list of \l{WirelessAccessPoint}{WirelessAccessPoints} which have been added or changed after the given \a generation. */
+QList<WirelessAccessPoint *> WirelessNetworkDevice::accessPointsChangedSince(quint32 generation) const
+{
+    QList<WirelessAccessPoint *> accessPoints;
+    foreach (WirelessAccessPoint *accessPoint, m_accessPointsTable) {
+        if (accessPoint->generation() > generation) {
+            accessPoints.append(accessPoint);
+        }
+    }
+    return accessPoints;
+}
+
+/*! Returns the list of BSSIDs (mac addresses) of the \l{WirelessAccessPoint}{WirelessAccessPoints} which have been removed after the given \a generation. */
+QStringList WirelessNetworkDevice::accessPointsRemovedSince(quint32 generation) const
+{
+    QStringList bssids;
+    // Note: the tombstones are sorted by generation
+    for (int i = m_accessPointTombstones.count() - 1; i >= 0; i--) {
+        if (m_accessPointTombstones.at(i).generation <= generation)
+            break;
+
+        bssids.prepend(m_accessPointTombstones.at(i).bssid);
+    }
+    return bssids;
+}
+
+bool WirelessNetworkDevice::initWirelessInterface()
+{
+    // Collect access point changes arriving in bursts, i.e. while scanning
+    m_accessPointBatchTimer = new QTimer(this);
+    m_accessPointBatchTimer->setInterval(100);
+    m_accessPointBatchTimer->setSingleShot(true);
+    connect(m_accessPointBatchTimer, &QTimer::timeout, this, &WirelessNetworkDevice::onAccessPointBatchTimeout);
+
+    // Note: NetworkManager < 1.12 does not announce finished scans using LastScan
+    m_scanTimeoutTimer = new QTimer(this);
+    m_scanTimeoutTimer->setInterval(15000);
+    m_scanTimeoutTimer->setSingleShot(true);
+    connect(m_scanTimeoutTimer, &QTimer::timeout, this, &WirelessNetworkDevice::onScanTimeout);
+
+    QDBusConnection systemBus = QDBusConnection::systemBus();
+    if (!systemBus.isConnected()) {
+        qCWarning(dcNetworkManager()) << "WirelessNetworkDevice: System DBus not connected";
+        return false;
+    }
+
+    m_wirelessInterface = new NetworkManagerDBusProxy(this->objectPath().path(), NetworkManagerUtils::wirelessInterfaceString(), systemBus, this);
+    if (!m_wirelessInterface->isValid()) {
+        qCWarning(dcNetworkManager()) << "WirelessNetworkDevice: Invalid wireless dbus interface";
+        return false;
+    }
+
+    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), NetworkManagerUtils::wirelessInterfaceString(), "AccessPointAdded", this, SLOT(accessPointAdded(QDBusObjectPath)));
+    QDBusConnection::systemBus().connect(NetworkManagerUtils::networkManagerServiceString(), this->objectPath().path(), NetworkManagerUtils::wirelessInterfaceString(), "AccessPointRemoved", this, SLOT(accessPointRemoved(QDBusObjectPath)));
+    // Note: property changes get dispatched by the NetworkManager
+    return true;
+}
+
 void WirelessNetworkDevice::readAccessPoints()
 {
     QDBusMessage query = m_wirelessInterface->call("GetAccessPoints");
@@ -168,6 +378,30 @@ void WirelessNetworkDevice::readAccessPoints()
         accessPointAdded(accessPointObjectPath);
     }
     argument.endArray();
+
+    // No need to wait for more access points, load the initial list right away
+    m_accessPointBatchTimer->stop();
+    onAccessPointBatchTimeout();
+}
+
+void WirelessNetworkDevice::readAccessPoints(const QVariant &accessPointPaths, const NMManagedObjects &managedObjects)
+{
+    const QDBusArgument argument = accessPointPaths.value<QDBusArgument>();
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        QDBusObjectPath accessPointObjectPath = qdbus_cast<QDBusObjectPath>(argument);
+        if (m_accessPointsTable.contains(accessPointObjectPath))
+            continue;
+
+        // The access point might have shown up after the managed objects have been fetched
+        if (!managedObjects.value(accessPointObjectPath).contains(NetworkManagerUtils::accessPointInterfaceString())) {
+            accessPointAdded(accessPointObjectPath);
+            continue;
+        }
+
+        addAccessPoint(new WirelessAccessPoint(accessPointObjectPath, managedObjects.value(accessPointObjectPath).value(NetworkManagerUtils::accessPointInterfaceString()), this));
+    }
+    argument.endArray();
 }
 
 void WirelessNetworkDevice::setActiveAccessPoint(const QDBusObjectPath &activeAccessPointObjectPath)
@@ -176,88 +410,227 @@ void WirelessNetworkDevice::setActiveAccessPoint(const QDBusObjectPath &activeAc
         m_activeAccessPointObjectPath = activeAccessPointObjectPath;
         if (m_accessPointsTable.contains(m_activeAccessPointObjectPath)) {
             if (m_activeAccessPoint)
-                disconnect(m_activeAccessPoint, &WirelessAccessPoint::signalStrengthChanged, this, &WirelessNetworkDevice::deviceChanged);
+                disconnect(m_activeAccessPoint, &WirelessAccessPoint::signalStrengthChanged, this, &WirelessNetworkDevice::onActiveAccessPointSignalStrengthChanged);
 
             // Set new access point object
             m_activeAccessPoint = m_accessPointsTable.value(activeAccessPointObjectPath);
             // Update the device when the signalstrength changed
-            connect(m_activeAccessPoint, &WirelessAccessPoint::signalStrengthChanged, this, &WirelessNetworkDevice::deviceChanged);
+            connect(m_activeAccessPoint, &WirelessAccessPoint::signalStrengthChanged, this, &WirelessNetworkDevice::onActiveAccessPointSignalStrengthChanged);
         } else {
             m_activeAccessPoint = nullptr;
         }
-        emit deviceChanged();
+        notifyDeviceChanged(DeviceChangeActiveAccessPoint);
     }
 }
 
-void WirelessNetworkDevice::accessPointAdded(const QDBusObjectPath &objectPath)
+void WirelessNetworkDevice::addAccessPoint(WirelessAccessPoint *accessPoint)
 {
-    QDBusInterface accessPointInterface(NetworkManagerUtils::networkManagerServiceString(), objectPath.path(), NetworkManagerUtils::accessPointInterfaceString(), QDBusConnection::systemBus());
-    if (!accessPointInterface.isValid()) {
-        qCWarning(dcNetworkManager()) << this << "Invalid access point dbus interface";
-        return;
+    qCDebug(dcNetworkManager()) << interface() << "[+]" << accessPoint;
+    m_accessPointsTable.insert(accessPoint->objectPath(), accessPoint);
+    m_accessPointsBySsid.insert(accessPoint->ssid(), accessPoint);
+    m_accessPointsByBssid.insert(accessPoint->macAddress().toUpper(), accessPoint);
+    bumpAccessPointGeneration(accessPoint);
+    connect(accessPoint, &WirelessAccessPoint::signalStrengthChanged, this, [this, accessPoint](){
+        bumpAccessPointGeneration(accessPoint);
+    });
+
+    // The active access point might have been announced before the access point itself has been loaded
+    if (!m_activeAccessPoint && accessPoint->objectPath() == m_activeAccessPointObjectPath) {
+        m_activeAccessPoint = accessPoint;
+        connect(m_activeAccessPoint, &WirelessAccessPoint::signalStrengthChanged, this, &WirelessNetworkDevice::onActiveAccessPointSignalStrengthChanged);
+        notifyDeviceChanged(DeviceChangeActiveAccessPoint);
     }
 
-    if (m_accessPointsTable.keys().contains(objectPath)) {
+    emit accessPointLoaded(accessPoint);
+}
+
+WirelessAccessPoint *WirelessNetworkDevice::takeAccessPoint(const QDBusObjectPath &objectPath)
+{
+    WirelessAccessPoint *accessPoint = m_accessPointsTable.take(objectPath);
+    if (!accessPoint)
+        return nullptr;
+
+    m_accessPointsBySsid.remove(accessPoint->ssid(), accessPoint);
+
+    // Note: the same BSSID might have been announced again using a new object path
+    const QString bssid = accessPoint->macAddress().toUpper();
+    if (m_accessPointsByBssid.value(bssid) == accessPoint)
+        m_accessPointsByBssid.remove(bssid);
+
+    if (accessPoint == m_activeAccessPoint)
+        m_activeAccessPoint = nullptr;
+
+    disconnect(accessPoint, nullptr, this, nullptr);
+
+    // Remember the removal unless the BSSID is still available using another object path
+    if (!m_accessPointsByBssid.contains(bssid)) {
+        AccessPointTombstone tombstone;
+        tombstone.bssid = accessPoint->macAddress();
+        tombstone.generation = ++m_accessPointGeneration;
+        m_accessPointTombstones.append(tombstone);
+
+        // Limit the memory, older generations will require the full access point list
+        if (m_accessPointTombstones.count() > 512)
+            m_accessPointGenerationHorizon = m_accessPointTombstones.takeFirst().generation;
+
+        emit accessPointGenerationChanged(m_accessPointGeneration);
+    }
+
+    emit accessPointUnloaded(accessPoint);
+    return accessPoint;
+}
+
+void WirelessNetworkDevice::loadAccessPoint(const QDBusObjectPath &objectPath)
+{
+    m_loadingAccessPoints.insert(objectPath);
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(NetworkManagerDBusProxy::readObjectPropertiesAsync(objectPath.path(), NetworkManagerUtils::accessPointInterfaceString()), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, objectPath](QDBusPendingCallWatcher *call){
+        call->deleteLater();
+
+        // Removed while loading
+        if (!m_loadingAccessPoints.remove(objectPath))
+            return;
+
+        QDBusPendingReply<QVariantMap> reply = *call;
+        if (reply.isError()) {
+            qCWarning(dcNetworkManager()) << this << "Could not load access point" << objectPath.path() << reply.error().name() << reply.error().message();
+        } else {
+            addAccessPoint(new WirelessAccessPoint(objectPath, reply.value(), this));
+            m_accessPointsChanged = true;
+        }
+
+        if (m_loadingAccessPoints.isEmpty())
+            finishAccessPointBatch();
+    });
+}
+
+void WirelessNetworkDevice::finishAccessPointBatch()
+{
+    if (!m_accessPointsChanged)
+        return;
+
+    m_accessPointsChanged = false;
+    emit accessPointsChanged();
+}
+
+void WirelessNetworkDevice::bumpAccessPointGeneration(WirelessAccessPoint *accessPoint)
+{
+    accessPoint->m_generation = ++m_accessPointGeneration;
+    emit accessPointGenerationChanged(m_accessPointGeneration);
+}
+
+void WirelessNetworkDevice::accessPointAdded(const QDBusObjectPath &objectPath)
+{
+    if (m_accessPointsTable.contains(objectPath) || m_loadingAccessPoints.contains(objectPath)) {
         qCWarning(dcNetworkManager()) << this << "Access point already added" << objectPath.path();
         return;
     }
 
-    WirelessAccessPoint *accessPoint = new WirelessAccessPoint(objectPath, this);
-    qCDebug(dcNetworkManager()) << interface() << "[+]" << accessPoint;
-    m_accessPointsTable.insert(objectPath, accessPoint);
+    if (m_pendingAccessPoints.contains(objectPath))
+        return;
+
+    m_pendingAccessPoints.append(objectPath);
+    if (!m_accessPointBatchTimer->isActive())
+        m_accessPointBatchTimer->start();
 }
 
 void WirelessNetworkDevice::accessPointRemoved(const QDBusObjectPath &objectPath)
 {
-    if (!m_accessPointsTable.keys().contains(objectPath))
+    // Not loaded yet
+    if (m_pendingAccessPoints.removeAll(objectPath) > 0 || m_loadingAccessPoints.remove(objectPath)) {
+        if (m_loadingAccessPoints.isEmpty() && !m_accessPointBatchTimer->isActive())
+            m_accessPointBatchTimer->start();
+
         return;
+    }
 
-    WirelessAccessPoint *accessPoint = m_accessPointsTable.take(objectPath);
-    if (accessPoint == m_activeAccessPoint)
-        m_activeAccessPoint = nullptr;
+    WirelessAccessPoint *accessPoint = takeAccessPoint(objectPath);
+    if (!accessPoint)
+        return;
 
     qCDebug(dcNetworkManager()) << interface() << "[-]" << accessPoint;
     accessPoint->deleteLater();
+
+    // Coalesce the notification with other changes of this batch
+    m_accessPointsChanged = true;
+    if (!m_accessPointBatchTimer->isActive())
+        m_accessPointBatchTimer->start();
+}
+
+void WirelessNetworkDevice::onAccessPointBatchTimeout()
+{
+    if (!m_pendingAccessPoints.isEmpty())
+        qCDebug(dcNetworkManager()) << this << "Loading" << m_pendingAccessPoints.count() << "access points";
+
+    foreach (const QDBusObjectPath &objectPath, m_pendingAccessPoints) {
+        loadAccessPoint(objectPath);
+    }
+    m_pendingAccessPoints.clear();
+
+    // The batch is finished once all access points have been loaded
+    if (m_loadingAccessPoints.isEmpty())
+        finishAccessPointBatch();
 }
 
 void WirelessNetworkDevice::processProperties(const QVariantMap &properties)
 {
     //qCDebug(dcNetworkManager()) << "WirelessNetworkDevice: Property changed" << properties;
 
-    if (properties.contains("Bitrate")) {
+    DeviceChanges changes = DeviceChangeNone;
+
+    if (properties.contains("Bitrate") && m_bitRate != properties.value("Bitrate").toInt() / 1000) {
         m_bitRate = properties.value("Bitrate").toInt() / 1000;
         emit bitRateChanged(m_bitRate);
+        changes |= DeviceChangeBitRate;
     }
 
-    if (properties.contains("Mode")) {
-        m_wirelessMode = static_cast<WirelessMode>(m_wirelessInterface->property("Mode").toUInt());
+    if (properties.contains("Mode") && m_wirelessMode != static_cast<WirelessMode>(properties.value("Mode").toUInt())) {
+        m_wirelessMode = static_cast<WirelessMode>(properties.value("Mode").toUInt());
         emit wirelessModeChanged(m_wirelessMode);
+        changes |= DeviceChangeWirelessMode;
     }
 
-    if (properties.contains("WirelessCapabilities")) {
-        m_wirelessCapabilities = static_cast<WirelessCapabilities>(m_wirelessInterface->property("WirelessCapabilities").toUInt());
+    if (properties.contains("WirelessCapabilities") && m_wirelessCapabilities != static_cast<WirelessCapabilities>(properties.value("WirelessCapabilities").toUInt())) {
+        m_wirelessCapabilities = static_cast<WirelessCapabilities>(properties.value("WirelessCapabilities").toUInt());
         emit wirelessCapabilitiesChanged(m_wirelessCapabilities);
+        changes |= DeviceChangeWirelessCapabilities;
     }
 
     // Note: available since 1.12 (-1 means never scanned)
-    if (properties.contains("LastScan")) {
-        m_lastScan = m_wirelessInterface->property("LastScan").toInt();
+    if (properties.contains("LastScan") && m_lastScan != properties.value("LastScan").toLongLong()) {
+        bool advanced = properties.value("LastScan").toLongLong() > m_lastScan;
+        m_lastScan = properties.value("LastScan").toLongLong();
         emit lastScanChanged(m_lastScan);
+        changes |= DeviceChangeLastScan;
+        if (advanced)
+            finishScan();
     }
 
     if (properties.contains("ActiveAccessPoint")) {
         setActiveAccessPoint(qdbus_cast<QDBusObjectPath>(properties.value("ActiveAccessPoint")));
     }
 
-    emit deviceChanged();
+    notifyDeviceChanged(changes);
+}
+
+void WirelessNetworkDevice::onActiveAccessPointSignalStrengthChanged()
+{
+    notifyDeviceChanged(DeviceChangeSignalStrength);
+}
+
+void WirelessNetworkDevice::onScanTimeout()
+{
+    qCDebug(dcNetworkManager()) << this << "Scan did not report a finished scan in time";
+    finishScan();
 }
 
-void WirelessNetworkDevice::onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties)
+void WirelessNetworkDevice::finishScan()
 {
-    Q_UNUSED(interface)
-    Q_UNUSED(invalidatedProperties)
-    //qCDebug(dcNetworkManager()) << "WirelessNetworkDevice: Properties changed" << interface << changedProperties << invalidatedProperties;
-    processProperties(changedProperties);
+    m_scanning = false;
+    m_scanTimeoutTimer->stop();
+    m_scanFinishedTimer.start();
+    emit scanFinished();
 }
 
 /*! Writes the given \a device to the given to \a debug. \sa WirelessNetworkDevice, */
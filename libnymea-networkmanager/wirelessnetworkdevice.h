@@ -25,10 +25,13 @@
 #ifndef WIRELESSNETWORKMANAGER_H
 #define WIRELESSNETWORKMANAGER_H
 
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QDebug>
 #include <QDBusConnection>
-#include <QDBusInterface>
 #include <QDBusMessage>
 #include <QDBusContext>
 #include <QDBusArgument>
@@ -39,6 +42,8 @@
 class WirelessNetworkDevice : public NetworkDevice
 {
     Q_OBJECT
+    friend class NetworkManager;
+
 public:
     enum WirelessMode {
         WirelessModeUnknown          = 0,
@@ -68,6 +73,7 @@ public:
     Q_FLAG(WirelessCapabilities)
 
     explicit WirelessNetworkDevice(const QDBusObjectPath &objectPath, QObject *parent = nullptr);
+    explicit WirelessNetworkDevice(const QDBusObjectPath &objectPath, const NMManagedObjects &managedObjects, QObject *parent = nullptr);
 
     // Properties
     QString macAddress() const;
@@ -80,38 +86,96 @@ public:
     QList<WirelessAccessPoint *> accessPoints();
     WirelessAccessPoint *getAccessPoint(const QString &ssid);
     WirelessAccessPoint *getAccessPoint(const QDBusObjectPath &objectPath);
+    WirelessAccessPoint *getAccessPointByBssid(const QString &bssid);
+
+    // Access point changes
+    quint32 accessPointGeneration() const;
+    bool accessPointChangesAvailable(quint32 generation) const;
+    QList<WirelessAccessPoint *> accessPointsChangedSince(quint32 generation) const;
+    QStringList accessPointsRemovedSince(quint32 generation) const;
 
     // Methods
     void scanWirelessNetworks();
+    QDBusPendingReply<> scanWirelessNetworksAsync();
+
+    // Scan scheduling
+    qint64 lastScan() const;
+    qint64 lastScanAge() const;
+    bool scanning() const;
+
+    int scanMaxAge() const;
+    void setScanMaxAge(int scanMaxAge);
+
+    bool requestScan(bool force = false);
 
 signals:
     void bitRateChanged(int bitRate);
     void wirelessCapabilitiesChanged(WirelessCapabilities wirelessCapabilities);
     void wirelessModeChanged(WirelessMode mode);
-    void lastScanChanged(int lastScan);
+    void lastScanChanged(qint64 lastScan);
+    void scanFinished();
+    void accessPointsChanged();
+    void accessPointGenerationChanged(quint32 generation);
+    void accessPointLoaded(WirelessAccessPoint *accessPoint);
+    void accessPointUnloaded(WirelessAccessPoint *accessPoint);
 
 private slots:
     void accessPointAdded(const QDBusObjectPath &objectPath);
     void accessPointRemoved(const QDBusObjectPath &objectPath);
     void processProperties(const QVariantMap &properties);
-    void onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties);
+    void onAccessPointBatchTimeout();
+    void onActiveAccessPointSignalStrengthChanged();
+    void onScanTimeout();
 
 private:
-    QDBusInterface *m_wirelessInterface = nullptr;
+    NetworkManagerDBusProxy *m_wirelessInterface = nullptr;
     WirelessAccessPoint *m_activeAccessPoint = nullptr;
 
     int m_bitRate;
     QString m_macAddress;
     WirelessCapabilities m_wirelessCapabilities = WirelessCapabilityNone;
     WirelessMode m_wirelessMode = WirelessModeUnknown;
-    int m_lastScan = -1;
+    qint64 m_lastScan = -1;
     QDBusObjectPath m_activeAccessPointObjectPath;
 
     QHash<QDBusObjectPath, WirelessAccessPoint *> m_accessPointsTable;
+    QMultiHash<QString, WirelessAccessPoint *> m_accessPointsBySsid;
+    QHash<QString, WirelessAccessPoint *> m_accessPointsByBssid;
+
+    // Access points get loaded in batches
+    QTimer *m_accessPointBatchTimer = nullptr;
+    QList<QDBusObjectPath> m_pendingAccessPoints;
+    QSet<QDBusObjectPath> m_loadingAccessPoints;
+    bool m_accessPointsChanged = false;
+
+    // Access point changes, removed access points are remembered by BSSID
+    struct AccessPointTombstone {
+        QString bssid;
+        quint32 generation;
+    };
+    quint32 m_accessPointGeneration = 0;
+    quint32 m_accessPointGenerationHorizon = 0;
+    QList<AccessPointTombstone> m_accessPointTombstones;
+
+    // Scan scheduling
+    QTimer *m_scanTimeoutTimer = nullptr;
+    QElapsedTimer m_scanFinishedTimer;
+    int m_scanMaxAge = 10000;
+    bool m_scanning = false;
 
+    bool initWirelessInterface();
     void readAccessPoints();
+    void readAccessPoints(const QVariant &accessPointPaths, const NMManagedObjects &managedObjects);
 
     void setActiveAccessPoint(const QDBusObjectPath &activeAccessPointObjectPath);
+
+    void addAccessPoint(WirelessAccessPoint *accessPoint);
+    WirelessAccessPoint *takeAccessPoint(const QDBusObjectPath &objectPath);
+    void loadAccessPoint(const QDBusObjectPath &objectPath);
+    void finishAccessPointBatch();
+    void bumpAccessPointGeneration(WirelessAccessPoint *accessPoint);
+
+    void finishScan();
 };
 
 QDebug operator<<(QDebug debug, WirelessNetworkDevice *device);
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <QtTest>
+
+#include "networksettings.h"
+
+class TestNetworkSettings : public QObject
+{
+    Q_OBJECT
+
+private:
+    ConnectionSettings requestedSettings(bool hidden = false) const;
+    ConnectionSettings storedSettings() const;
+
+private slots:
+    void settingsAppliedWithDefaultValues();
+    void settingsAppliedChangedPassword();
+    void settingsAppliedChangedDefaultValue();
+    void settingsAppliedOpenNetwork();
+    void mergeSettingsKeepsUuid();
+    void mergeSettingsResetsHidden();
+    void connectionTypeMatchesWirelessMode();
+
+};
+
+ConnectionSettings TestNetworkSettings::requestedSettings(bool hidden) const
+{
+    // Note: built like NetworkManager::connectWifiAsync() does
+    ConnectionSettings settings;
+    settings["connection"].insert("autoconnect", true);
+    settings["connection"].insert("id", "nymea");
+    settings["connection"].insert("uuid", "f0b4b6e2-7a6f-4a55-9d6b-1c4e2b6a0c11");
+    settings["connection"].insert("type", "802-11-wireless");
+    settings["connection"].insert("autoconnect-retries", 0);
+    settings["802-11-wireless"].insert("ssid", QByteArray("nymea"));
+    settings["802-11-wireless"].insert("mode", "infrastructure");
+    settings["802-11-wireless"].insert("powersave", 2);
+    if (hidden)
+        settings["802-11-wireless"].insert("hidden", true);
+
+    settings["802-11-wireless-security"].insert("auth-alg", "open");
+    settings["802-11-wireless-security"].insert("key-mgmt", "wpa-psk");
+    settings["802-11-wireless-security"].insert("psk", "secret123");
+    settings["ipv4"].insert("method", "auto");
+    settings["ipv6"].insert("method", "auto");
+    return settings;
+}
+
+ConnectionSettings TestNetworkSettings::storedSettings() const
+{
+    // Note: like GetSettings merged with GetSecrets, properties at their default value are omitted and integers are unsigned
+    ConnectionSettings settings;
+    settings["connection"].insert("id", "nymea");
+    settings["connection"].insert("uuid", "3c9b1c1e-2f0a-4d43-8e0e-5b7e7a9d2f42");
+    settings["connection"].insert("type", "802-11-wireless");
+    settings["connection"].insert("autoconnect-retries", 0);
+    settings["connection"].insert("timestamp", QVariant::fromValue<quint64>(1700000000));
+    settings["802-11-wireless"].insert("ssid", QByteArray("nymea"));
+    settings["802-11-wireless"].insert("powersave", 2u);
+    settings["802-11-wireless"].insert("seen-bssids", QStringList() << "00:11:22:33:44:55");
+    settings["802-11-wireless-security"].insert("auth-alg", "open");
+    settings["802-11-wireless-security"].insert("key-mgmt", "wpa-psk");
+    settings["802-11-wireless-security"].insert("psk", "secret123");
+    settings["ipv4"].insert("method", "auto");
+    settings["ipv6"].insert("method", "auto");
+    return settings;
+}
+
+void TestNetworkSettings::settingsAppliedWithDefaultValues()
+{
+    // The settings differ only in properties which are at their default value
+    QVERIFY(NetworkSettings::settingsApplied(storedSettings(), requestedSettings()));
+}
+
+void TestNetworkSettings::settingsAppliedChangedPassword()
+{
+    ConnectionSettings settings = requestedSettings();
+    settings["802-11-wireless-security"].insert("psk", "secret456");
+    QVERIFY(!NetworkSettings::settingsApplied(storedSettings(), settings));
+}
+
+void TestNetworkSettings::settingsAppliedChangedDefaultValue()
+{
+    ConnectionSettings stored = storedSettings();
+    stored["connection"].insert("autoconnect", false);
+    QVERIFY(!NetworkSettings::settingsApplied(stored, requestedSettings()));
+
+    stored = storedSettings();
+    stored["802-11-wireless"].insert("hidden", true);
+    QVERIFY(!NetworkSettings::settingsApplied(stored, requestedSettings()));
+    QVERIFY(NetworkSettings::settingsApplied(stored, requestedSettings(true)));
+}
+
+void TestNetworkSettings::settingsAppliedOpenNetwork()
+{
+    ConnectionSettings settings = requestedSettings();
+    settings.remove("802-11-wireless-security");
+    QVERIFY(!NetworkSettings::settingsApplied(storedSettings(), settings));
+
+    ConnectionSettings merged = NetworkSettings::mergeSettings(storedSettings(), settings);
+    QVERIFY(!merged.contains("802-11-wireless-security"));
+    QVERIFY(NetworkSettings::settingsApplied(merged, settings));
+}
+
+void TestNetworkSettings::mergeSettingsKeepsUuid()
+{
+    ConnectionSettings settings = requestedSettings();
+    settings["802-11-wireless-security"].insert("psk", "secret456");
+
+    ConnectionSettings merged = NetworkSettings::mergeSettings(storedSettings(), settings);
+    QCOMPARE(merged.value("connection").value("uuid"), storedSettings().value("connection").value("uuid"));
+    QCOMPARE(merged.value("802-11-wireless-security").value("psk").toString(), QString("secret456"));
+    QCOMPARE(merged.value("802-11-wireless").value("seen-bssids"), storedSettings().value("802-11-wireless").value("seen-bssids"));
+    QVERIFY(NetworkSettings::settingsApplied(merged, settings));
+}
+
+void TestNetworkSettings::mergeSettingsResetsHidden()
+{
+    ConnectionSettings stored = storedSettings();
+    stored["802-11-wireless"].insert("hidden", true);
+
+    ConnectionSettings merged = NetworkSettings::mergeSettings(stored, requestedSettings());
+    QVERIFY(!merged.value("802-11-wireless").contains("hidden"));
+    QVERIFY(NetworkSettings::settingsApplied(merged, requestedSettings()));
+}
+
+void TestNetworkSettings::connectionTypeMatchesWirelessMode()
+{
+    // A missing mode means infrastructure
+    QVERIFY(NetworkSettings::connectionTypeMatches("802-11-wireless", QString(), requestedSettings()));
+    QVERIFY(NetworkSettings::connectionTypeMatches("802-11-wireless", "infrastructure", requestedSettings()));
+
+    // A hotspot with the same id must not be reused for a client connection and vice versa
+    QVERIFY(!NetworkSettings::connectionTypeMatches("802-11-wireless", "ap", requestedSettings()));
+
+    ConnectionSettings accessPointSettings = requestedSettings();
+    accessPointSettings["802-11-wireless"].insert("mode", "ap");
+    QVERIFY(NetworkSettings::connectionTypeMatches("802-11-wireless", "ap", accessPointSettings));
+    QVERIFY(!NetworkSettings::connectionTypeMatches("802-11-wireless", QString(), accessPointSettings));
+    QVERIFY(!NetworkSettings::connectionTypeMatches("802-11-wireless", "infrastructure", accessPointSettings));
+
+    ConnectionSettings settings = requestedSettings();
+    settings["802-11-wireless"].remove("mode");
+    QVERIFY(NetworkSettings::connectionTypeMatches("802-11-wireless", QString(), settings));
+    QVERIFY(!NetworkSettings::connectionTypeMatches("802-11-wireless", "ap", settings));
+
+    QVERIFY(!NetworkSettings::connectionTypeMatches("802-3-ethernet", QString(), requestedSettings()));
+}
+
+QTEST_GUILESS_MAIN(TestNetworkSettings)
+
+#include "testnetworksettings.moc"
@@ -0,0 +1,6 @@
+TARGET = testnetworksettings
+
+include(../tests.pri)
+
+SOURCES += \
+    testnetworksettings.cpp
@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+SUBDIRS += testnetworksettings
+
+lessThan(QT_MAJOR_VERSION, 6):lessThan(QT_MINOR_VERSION, 7) {
+    message(Bluetooth LE tests not supported with Qt $${QT_VERSION}.)
+} else {
+    SUBDIRS += testtransmitqueue
+}
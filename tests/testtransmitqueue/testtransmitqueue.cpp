@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of libnymea-networkmanager.
+*
+* libnymea-networkmanager is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* libnymea-networkmanager is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with libnymea-networkmanager. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QLowEnergyController>
+#include <QLowEnergyServiceData>
+#include <QLowEnergyDescriptorData>
+#include <QLowEnergyCharacteristicData>
+
+#include "bluetooth/transmitqueue.h"
+
+static const QBluetoothUuid testServiceUuid(QUuid("e081fec0-f757-4449-b9c9-bfa83133f7fc"));
+static const QBluetoothUuid testCharacteristicUuid(QUuid("e081fec3-f757-4449-b9c9-bfa83133f7fc"));
+
+class TestTransmitQueue : public QObject
+{
+    Q_OBJECT
+
+private:
+    QLowEnergyController *m_controller = nullptr;
+    QLowEnergyService *m_service = nullptr;
+
+    QByteArray networksResponse(int count) const;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void pacedNetworksResponse();
+
+};
+
+QByteArray TestTransmitQueue::networksResponse(int count) const
+{
+    // Note: built like the JSON GetNetworks response of the WirelessService
+    QJsonArray networks;
+    for (int i = 0; i < count; i++) {
+        QJsonObject network;
+        network.insert("e", QString("Network %1").arg(i, 2, 10, QChar('0')));
+        network.insert("m", QString("00:11:22:33:44:%1").arg(i, 2, 16, QChar('0')));
+        network.insert("s", 100 - i);
+        network.insert("p", i % 2);
+        networks.append(network);
+    }
+
+    QJsonObject response;
+    response.insert("c", 3);
+    response.insert("r", 0);
+    response.insert("p", networks);
+    return QJsonDocument(response).toJson(QJsonDocument::Compact) + '\n';
+}
+
+void TestTransmitQueue::initTestCase()
+{
+    QLowEnergyServiceData serviceData;
+    serviceData.setType(QLowEnergyServiceData::ServiceTypePrimary);
+    serviceData.setUuid(testServiceUuid);
+
+    QLowEnergyCharacteristicData characteristicData;
+    characteristicData.setUuid(testCharacteristicUuid);
+    characteristicData.setProperties(QLowEnergyCharacteristic::Notify);
+#if QT_VERSION < QT_VERSION_CHECK(6,0,0)
+    characteristicData.addDescriptor(QLowEnergyDescriptorData(QBluetoothUuid::ClientCharacteristicConfiguration, QByteArray(2, 0)));
+#endif
+    characteristicData.setValueLength(0, 512);
+    serviceData.addCharacteristic(characteristicData);
+
+    m_controller = QLowEnergyController::createPeripheral(this);
+    m_service = m_controller->addService(serviceData, m_controller);
+    if (!m_service || !m_service->characteristic(testCharacteristicUuid).isValid())
+        QSKIP("Bluetooth LE peripheral services are not available on this system.");
+}
+
+void TestTransmitQueue::cleanupTestCase()
+{
+    delete m_controller;
+    m_controller = nullptr;
+    m_service = nullptr;
+}
+
+void TestTransmitQueue::pacedNetworksResponse()
+{
+    TransmitQueue queue(m_service, testCharacteristicUuid);
+    queue.setPackageSize(20);
+    queue.setWindowSize(4);
+    queue.setInterval(20);
+
+    QList<QByteArray> packages = queue.createPackages(networksResponse(60));
+    QVERIFY(packages.count() > 10 * queue.windowSize());
+
+    // Every batch gets written within sendPackages(), which reports the new queue depth afterwards
+    QList<int> batches;
+    QList<qint64> batchTimes;
+    quint64 packagesSent = 0;
+    QElapsedTimer timer;
+    timer.start();
+    connect(&queue, &TransmitQueue::queueDepthChanged, this, [&](int queueDepth) {
+        Q_UNUSED(queueDepth)
+        int batch = static_cast<int>(queue.packagesSent() - packagesSent);
+        packagesSent = queue.packagesSent();
+        if (batch > 0) {
+            batches.append(batch);
+            batchTimes.append(timer.elapsed());
+        }
+    });
+
+    // Written notifications reported by the stack must not return credits
+    QLowEnergyCharacteristic characteristic = m_service->characteristic(testCharacteristicUuid);
+    QTimer writtenTimer;
+    writtenTimer.setInterval(1);
+    connect(&writtenTimer, &QTimer::timeout, this, [&]() {
+        emit m_service->characteristicWritten(characteristic, QByteArray(20, 'x'));
+    });
+    writtenTimer.start();
+
+    QSignalSpy messageSentSpy(&queue, &TransmitQueue::messageSent);
+    queue.enqueuePackages(packages, 3);
+    QTRY_COMPARE_WITH_TIMEOUT(messageSentSpy.count(), 1, 10000);
+    writtenTimer.stop();
+
+    QCOMPARE(messageSentSpy.first().first().toInt(), 3);
+    QCOMPARE(queue.packagesSent(), static_cast<quint64>(packages.count()));
+    QCOMPARE(queue.queueDepth(), 0);
+    QVERIFY(batches.count() >= (packages.count() + queue.windowSize() - 1) / queue.windowSize());
+
+    for (int i = 0; i < batches.count(); i++) {
+        QVERIFY2(batches.at(i) <= queue.windowSize(), qPrintable(QString("Batch %1 sent %2 packages").arg(i).arg(batches.at(i))));
+        // Note: coarse timers may fire up to 5% early
+        if (i > 0) {
+            QVERIFY2(batchTimes.at(i) - batchTimes.at(i - 1) >= queue.interval() * 95 / 100,
+                     qPrintable(QString("Batch %1 sent after %2 ms").arg(i).arg(batchTimes.at(i) - batchTimes.at(i - 1))));
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestTransmitQueue)
+
+#include "testtransmitqueue.moc"
@@ -0,0 +1,8 @@
+TARGET = testtransmitqueue
+
+include(../tests.pri)
+
+QT += bluetooth
+
+SOURCES += \
+    testtransmitqueue.cpp